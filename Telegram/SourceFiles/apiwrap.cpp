@@ -46,6 +46,7 @@ constexpr auto kSmallDelayMs = 5;
 
 ApiWrap::ApiWrap()
 : _messageDataResolveDelayed([this] { resolveMessageDatas(); })
+, _peersResolveDelayed([this] { resolvePeers(); })
 , _webPagesTimer([this] { resolveWebPages(); })
 , _draftsSaveTimer([this] { saveDraftsToCloud(); }) {
 	Window::Theme::Background()->start();
@@ -377,85 +378,110 @@ void ApiWrap::gotUserFull(UserData *user, const MTPUserFull &result, mtpRequestI
 }
 
 void ApiWrap::requestPeer(PeerData *peer) {
-	if (!peer || _fullPeerRequests.contains(peer) || _peerRequests.contains(peer)) return;
+	if (!peer || _fullPeerRequests.contains(peer) || _peerRequests.contains(peer) || _peerRequestsPending.contains(peer)) return;
 
-	auto sendRequest = [this, peer] {
-		auto failHandler = [this, peer](const RPCError &error) {
-			_peerRequests.remove(peer);
-		};
-		auto chatHandler = [this, peer](const MTPmessages_Chats &result) {
-			_peerRequests.remove(peer);
-
-			if (auto chats = Api::getChatsFromMessagesChats(result)) {
-				auto &v = chats->v;
-				bool badVersion = false;
-				if (peer->isChat()) {
-					badVersion = (!v.isEmpty() && v.at(0).type() == mtpc_chat && v.at(0).c_chat().vversion.v < peer->asChat()->version);
-				} else if (peer->isChannel()) {
-					badVersion = (!v.isEmpty() && v.at(0).type() == mtpc_channel && v.at(0).c_chat().vversion.v < peer->asChannel()->version);
-				}
-				auto chat = App::feedChats(*chats);
-				if (chat == peer) {
-					if (badVersion) {
-						if (peer->isChat()) {
-							peer->asChat()->version = v.at(0).c_chat().vversion.v;
-						} else if (peer->isChannel()) {
-							peer->asChannel()->version = v.at(0).c_channel().vversion.v;
-						}
-						requestPeer(peer);
-					}
-				}
-			}
-		};
+	_peerRequestsPending.insert(peer);
+	_peersResolveDelayed.call();
+}
+
+void ApiWrap::requestPeers(const QList<PeerData*> &peers) {
+	for_const (auto peer, peers) {
+		requestPeer(peer);
+	}
+}
+
+void ApiWrap::resolvePeers() {
+	if (_peerRequestsPending.isEmpty()) return;
+
+	auto peers = QVector<PeerData*>();
+	peers.reserve(_peerRequestsPending.size());
+	for (auto peer : base::take(_peerRequestsPending)) {
+		if (!_fullPeerRequests.contains(peer)) {
+			peers.push_back(peer);
+		}
+	}
+	auto users = QVector<MTPInputUser>();
+	auto chats = QVector<MTPint>();
+	auto channels = QVector<MTPInputChannel>();
+	for_const (auto peer, peers) {
 		if (auto user = peer->asUser()) {
-			return request(MTPusers_GetUsers(MTP_vector<MTPInputUser>(1, user->inputUser))).done([this, user](const MTPVector<MTPUser> &result) {
-				_peerRequests.remove(user);
-				App::feedUsers(result);
-			}).fail(failHandler).send();
+			users.push_back(user->inputUser);
 		} else if (auto chat = peer->asChat()) {
-			return request(MTPmessages_GetChats(MTP_vector<MTPint>(1, chat->inputChat))).done(chatHandler).fail(failHandler).send();
+			chats.push_back(chat->inputChat);
 		} else if (auto channel = peer->asChannel()) {
-			return request(MTPchannels_GetChannels(MTP_vector<MTPInputChannel>(1, channel->inputChannel))).done(chatHandler).fail(failHandler).send();
+			channels.push_back(channel->inputChannel);
 		}
-		return 0;
+	}
+
+	auto failHandler = [this](const RPCError &error, mtpRequestId requestId) {
+		finishPeerRequests(requestId);
 	};
-	if (auto requestId = sendRequest()) {
-		_peerRequests.insert(peer, requestId);
+	auto chatsHandler = [this](const MTPmessages_Chats &result, mtpRequestId requestId) {
+		gotChats(result, requestId);
+	};
+	auto usersRequestId = users.isEmpty() ? 0 : request(MTPusers_GetUsers(MTP_vector<MTPInputUser>(users))).done([this](const MTPVector<MTPUser> &result, mtpRequestId requestId) {
+		finishPeerRequests(requestId);
+		App::feedUsers(result);
+	}).fail(failHandler).send();
+	auto chatsRequestId = chats.isEmpty() ? 0 : request(MTPmessages_GetChats(MTP_vector<MTPint>(chats))).done(chatsHandler).fail(failHandler).send();
+	auto channelsRequestId = channels.isEmpty() ? 0 : request(MTPchannels_GetChannels(MTP_vector<MTPInputChannel>(channels))).done(chatsHandler).fail(failHandler).send();
+
+	for_const (auto peer, peers) {
+		auto requestId = peer->isUser() ? usersRequestId : peer->isChat() ? chatsRequestId : channelsRequestId;
+		if (requestId) {
+			_peerRequests.insert(peer, requestId);
+		}
 	}
 }
 
-void ApiWrap::requestPeers(const QList<PeerData*> &peers) {
-	QVector<MTPint> chats;
-	QVector<MTPInputChannel> channels;
-	QVector<MTPInputUser> users;
-	chats.reserve(peers.size());
-	channels.reserve(peers.size());
-	users.reserve(peers.size());
-	for (QList<PeerData*>::const_iterator i = peers.cbegin(), e = peers.cend(); i != e; ++i) {
-		if (!*i || _fullPeerRequests.contains(*i) || _peerRequests.contains(*i)) continue;
-		if ((*i)->isUser()) {
-			users.push_back((*i)->asUser()->inputUser);
-		} else if ((*i)->isChat()) {
-			chats.push_back((*i)->asChat()->inputChat);
-		} else if ((*i)->isChannel()) {
-			channels.push_back((*i)->asChannel()->inputChannel);
+QVector<PeerData*> ApiWrap::finishPeerRequests(mtpRequestId requestId) {
+	auto result = QVector<PeerData*>();
+	for (auto i = _peerRequests.begin(); i != _peerRequests.end();) {
+		if (i.value() == requestId) {
+			result.push_back(i.key());
+			i = _peerRequests.erase(i);
+		} else {
+			++i;
 		}
 	}
-	auto handleChats = [this](const MTPmessages_Chats &result) {
-		if (auto chats = Api::getChatsFromMessagesChats(result)) {
-			App::feedChats(*chats);
+	return result;
+}
+
+void ApiWrap::gotChats(const MTPmessages_Chats &result, mtpRequestId requestId) {
+	auto peers = finishPeerRequests(requestId);
+	auto chats = Api::getChatsFromMessagesChats(result);
+	if (!chats) return;
+
+	// The server may return an older version than the one we've got from
+	// updates, in that case we accept its version and request the peer again.
+	auto outdated = QVector<QPair<PeerData*, int32>>();
+	for_const (auto &chat, chats->v) {
+		auto peer = (PeerData*)nullptr;
+		auto version = 0;
+		if (chat.type() == mtpc_chat) {
+			peer = App::chatLoaded(chat.c_chat().vid.v);
+			version = chat.c_chat().vversion.v;
+			if (!peer || version >= peer->asChat()->version) continue;
+		} else if (chat.type() == mtpc_channel) {
+			peer = App::channelLoaded(chat.c_channel().vid.v);
+			version = chat.c_channel().vversion.v;
+			if (!peer || version >= peer->asChannel()->version) continue;
+		} else {
+			continue;
+		}
+		if (peers.contains(peer)) {
+			outdated.push_back(qMakePair(peer, version));
 		}
-	};
-	if (!chats.isEmpty()) {
-		request(MTPmessages_GetChats(MTP_vector<MTPint>(chats))).done(handleChats).send();
-	}
-	if (!channels.isEmpty()) {
-		request(MTPchannels_GetChannels(MTP_vector<MTPInputChannel>(channels))).done(handleChats).send();
 	}
-	if (!users.isEmpty()) {
-		request(MTPusers_GetUsers(MTP_vector<MTPInputUser>(users))).done([this](const MTPVector<MTPUser> &result) {
-			App::feedUsers(result);
-		}).send();
+	App::feedChats(*chats);
+	for_const (auto &peerVersion, outdated) {
+		auto peer = peerVersion.first;
+		if (auto chat = peer->asChat()) {
+			chat->version = peerVersion.second;
+		} else if (auto channel = peer->asChannel()) {
+			channel->version = peerVersion.second;
+		}
+		requestPeer(peer);
 	}
 }
 
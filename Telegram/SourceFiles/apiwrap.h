@@ -107,6 +107,10 @@ private:
 	QVector<MTPint> collectMessageIds(const MessageDataRequests &requests);
 	MessageDataRequests *messageDataRequests(ChannelData *channel, bool onlyExisting = false);
 
+	void resolvePeers();
+	void gotChats(const MTPmessages_Chats &result, mtpRequestId requestId);
+	QVector<PeerData*> finishPeerRequests(mtpRequestId requestId);
+
 	void gotChatFull(PeerData *peer, const MTPmessages_ChatFull &result, mtpRequestId req);
 	void gotUserFull(UserData *user, const MTPUserFull &result, mtpRequestId req);
 	void lastParticipantsDone(ChannelData *peer, const MTPchannels_ChannelParticipants &result, mtpRequestId req);
@@ -126,6 +130,8 @@ private:
 	using PeerRequests = QMap<PeerData*, mtpRequestId>;
 	PeerRequests _fullPeerRequests;
 	PeerRequests _peerRequests;
+	OrderedSet<PeerData*> _peerRequestsPending;
+	SingleQueuedInvokation _peersResolveDelayed;
 
 	PeerRequests _participantsRequests;
 	PeerRequests _botsRequests;
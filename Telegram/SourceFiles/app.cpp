@@ -55,7 +55,7 @@ namespace {
 
 	UserData *self = nullptr;
 
-	using PeersData = QHash<PeerId, PeerData*>;
+	using PeersData = base::IdMap<PeerId, PeerData*>;
 	PeersData peersData;
 
 	using MutedPeers = QMap<PeerData*, bool>;
@@ -89,9 +89,9 @@ namespace {
 
 	Histories histories;
 
-	using MsgsData = QHash<MsgId, HistoryItem*>;
+	using MsgsData = base::IdMap<MsgId, HistoryItem*>;
 	MsgsData msgsData;
-	using ChannelMsgsData = QMap<ChannelId, MsgsData>;
+	using ChannelMsgsData = std::map<ChannelId, MsgsData>;
 	ChannelMsgsData channelMsgsData;
 
 	using RandomData = QMap<uint64, FullMsgId>;
@@ -1255,15 +1255,14 @@ namespace {
 
 	inline MsgsData *fetchMsgsData(ChannelId channelId, bool insert = true) {
 		if (channelId == NoChannel) return &msgsData;
-		ChannelMsgsData::iterator i = channelMsgsData.find(channelId);
+		auto i = channelMsgsData.find(channelId);
 		if (i == channelMsgsData.cend()) {
 			if (insert) {
-				i = channelMsgsData.insert(channelId, MsgsData());
-			} else {
-				return 0;
+				return &channelMsgsData[channelId];
 			}
+			return nullptr;
 		}
-		return &(*i);
+		return &i->second;
 	}
 
 	void feedWereDeleted(ChannelId channelId, const QVector<MTPint> &msgsIds) {
@@ -1274,10 +1273,9 @@ namespace {
 
 		QMap<History*, bool> historiesToCheck;
 		for (QVector<MTPint>::const_iterator i = msgsIds.cbegin(), e = msgsIds.cend(); i != e; ++i) {
-			MsgsData::const_iterator j = data->constFind(i->v);
-			if (j != data->cend()) {
-				History *h = (*j)->history();
-				(*j)->destroy();
+			if (auto item = data->value(i->v)) {
+				History *h = item->history();
+				item->destroy();
 				if (!h->lastMsg) historiesToCheck.insert(h, true);
 			} else {
 				if (channelHistory) {
@@ -1522,8 +1520,8 @@ namespace {
 	PeerData *peer(const PeerId &id, PeerData::LoadedStatus restriction) {
 		if (!id) return nullptr;
 
-		auto i = peersData.constFind(id);
-		if (i == peersData.cend()) {
+		auto result = peersData.value(id);
+		if (!result) {
 			PeerData *newData = nullptr;
 			if (peerIsUser(id)) {
 				newData = new UserData(id);
@@ -1535,21 +1533,22 @@ namespace {
 			t_assert(newData != nullptr);
 
 			newData->input = MTPinputPeer(MTP_inputPeerEmpty());
-			i = peersData.insert(id, newData);
+			peersData.insert(id, newData);
+			result = newData;
 		}
 		switch (restriction) {
 		case PeerData::MinimalLoaded: {
-			if (i.value()->loadedStatus == PeerData::NotLoaded) {
+			if (result->loadedStatus == PeerData::NotLoaded) {
 				return nullptr;
 			}
 		} break;
 		case PeerData::FullLoaded: {
-			if (i.value()->loadedStatus != PeerData::FullLoaded) {
+			if (result->loadedStatus != PeerData::FullLoaded) {
 				return nullptr;
 			}
 		} break;
 		}
-		return i.value();
+		return result;
 	}
 
 	void enumerateUsers(base::lambda<void(UserData*)> action) {
@@ -1587,19 +1586,19 @@ namespace {
 	}
 
 	PhotoData *photo(const PhotoId &photo) {
-		PhotosData::const_iterator i = ::photosData.constFind(photo);
-		if (i == ::photosData.cend()) {
-			i = ::photosData.insert(photo, new PhotoData(photo));
+		auto result = ::photosData.value(photo);
+		if (!result) {
+			result = new PhotoData(photo);
+			::photosData.insert(photo, result);
 		}
-		return i.value();
+		return result;
 	}
 
 	PhotoData *photoSet(const PhotoId &photo, PhotoData *convert, const uint64 &access, int32 date, const ImagePtr &thumb, const ImagePtr &medium, const ImagePtr &full) {
 		if (convert) {
 			if (convert->id != photo) {
-				PhotosData::iterator i = ::photosData.find(convert->id);
-				if (i != ::photosData.cend() && i.value() == convert) {
-					::photosData.erase(i);
+				if (::photosData.value(convert->id) == convert) {
+					::photosData.remove(convert->id);
 				}
 				convert->id = photo;
 				convert->uploadingData.reset();
@@ -1612,10 +1611,9 @@ namespace {
 				updateImage(convert->full, full);
 			}
 		}
-		PhotosData::const_iterator i = ::photosData.constFind(photo);
-		PhotoData *result;
+		auto result = ::photosData.value(photo);
 		LastPhotosMap::iterator inLastIter = lastPhotosMap.end();
-		if (i == ::photosData.cend()) {
+		if (!result) {
 			if (convert) {
 				result = convert;
 			} else {
@@ -1623,7 +1621,6 @@ namespace {
 			}
 			::photosData.insert(photo, result);
 		} else {
-			result = i.value();
 			if (result != convert && date) {
 				result->access = access;
 				result->date = date;
@@ -1648,11 +1645,12 @@ namespace {
 	}
 
 	DocumentData *document(const DocumentId &document) {
-		DocumentsData::const_iterator i = ::documentsData.constFind(document);
-		if (i == ::documentsData.cend()) {
-			i = ::documentsData.insert(document, DocumentData::create(document));
+		auto result = ::documentsData.value(document);
+		if (!result) {
+			result = DocumentData::create(document);
+			::documentsData.insert(document, result);
 		}
-		return i.value();
+		return result;
 	}
 
 	DocumentData *documentSet(const DocumentId &document, DocumentData *convert, const uint64 &access, int32 version, int32 date, const QVector<MTPDocumentAttribute> &attributes, const QString &mime, const ImagePtr &thumb, int32 dc, int32 size, const StorageImageLocation &thumbLocation) {
@@ -1662,9 +1660,8 @@ namespace {
 			MediaKey oldKey = convert->mediaKey();
 			bool idChanged = (convert->id != document);
 			if (idChanged) {
-				DocumentsData::iterator i = ::documentsData.find(convert->id);
-				if (i != ::documentsData.cend() && i.value() == convert) {
-					::documentsData.erase(i);
+				if (::documentsData.value(convert->id) == convert) {
+					::documentsData.remove(convert->id);
 				}
 
 				convert->id = document;
@@ -1700,9 +1697,8 @@ namespace {
 				Local::writeSavedGifs();
 			}
 		}
-		DocumentsData::const_iterator i = ::documentsData.constFind(document);
-		DocumentData *result;
-		if (i == ::documentsData.cend()) {
+		auto result = ::documentsData.value(document);
+		if (!result) {
 			if (convert) {
 				result = convert;
 			} else {
@@ -1718,7 +1714,6 @@ namespace {
 			}
 			::documentsData.insert(document, result);
 		} else {
-			result = i.value();
 			if (result != convert && date) {
 				result->setattributes(attributes);
 				versionChanged = result->setRemoteVersion(version);
@@ -1948,23 +1943,17 @@ namespace {
 		if (!itemId) return nullptr;
 
 		auto data = fetchMsgsData(channelId, false);
-		if (!data) return nullptr;
-
-		auto i = data->constFind(itemId);
-		if (i != data->cend()) {
-			return i.value();
-		}
-		return nullptr;
+		return data ? data->value(itemId) : nullptr;
 	}
 
 	void historyRegItem(HistoryItem *item) {
-		MsgsData *data = fetchMsgsData(item->channelId());
-		MsgsData::const_iterator i = data->constFind(item->id);
-		if (i == data->cend()) {
+		auto data = fetchMsgsData(item->channelId());
+		auto registered = data->value(item->id);
+		if (!registered) {
 			data->insert(item->id, item);
-		} else if (i.value() != item) {
+		} else if (registered != item) {
 			LOG(("App Error: trying to historyRegItem() an already registered item"));
-			i.value()->destroy();
+			registered->destroy();
 			data->insert(item->id, item);
 		}
 	}
@@ -1994,11 +1983,8 @@ namespace {
 		auto data = fetchMsgsData(item->channelId(), false);
 		if (!data) return;
 
-		auto i = data->find(item->id);
-		if (i != data->cend()) {
-			if (i.value() == item) {
-				data->erase(i);
-			}
+		if (data->value(item->id) == item) {
+			data->remove(item->id);
 		}
 		historyItemDetached(item);
 		auto j = ::dependentItems.find(item);
@@ -2039,7 +2025,7 @@ namespace {
 			}
 		}
 		for_const (auto &chMsgsData, channelMsgsData) {
-			for_const (auto item, chMsgsData) {
+			for_const (auto item, chMsgsData.second) {
 				if (item->detached()) {
 					toDelete.push_back(item);
 				}
@@ -2129,6 +2115,10 @@ namespace {
 		}
 	}
 
+	bool historyHasDependent(HistoryItem *dependency) {
+		return ::dependentItems.contains(dependency);
+	}
+
 	void historyRegRandom(uint64 randomId, const FullMsgId &itemId) {
 		randomData.insert(randomId, itemId);
 	}
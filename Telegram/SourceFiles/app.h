@@ -21,6 +21,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #pragma once
 
 #include "core/basic_types.h"
+#include "base/id_map.h"
 #include "history.h"
 #include "history/history_item.h"
 #include "history/history_media.h"
@@ -41,8 +42,8 @@ using GameItems = QHash<GameData*, HistoryItemsMap>;
 using SharedContactItems = QHash<int32, HistoryItemsMap>;
 using GifItems = QHash<Media::Clip::Reader*, HistoryItem*>;
 
-using PhotosData = QHash<PhotoId, PhotoData*>;
-using DocumentsData = QHash<DocumentId, DocumentData*>;
+using PhotosData = base::IdMap<PhotoId, PhotoData*>;
+using DocumentsData = base::IdMap<DocumentId, DocumentData*>;
 
 class LocationCoords;
 struct LocationData;
@@ -190,6 +191,7 @@ namespace App {
 	void historyClearItems();
 	void historyRegDependency(HistoryItem *dependent, HistoryItem *dependency);
 	void historyUnregDependency(HistoryItem *dependent, HistoryItem *dependency);
+	bool historyHasDependent(HistoryItem *dependency);
 
 	void historyRegRandom(uint64 randomId, const FullMsgId &itemId);
 	void historyUnregRandom(uint64 randomId);
@@ -30,6 +30,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "calls/calls_instance.h"
 #include "window/section_widget.h"
 #include "chat_helpers/tabbed_selector.h"
+#include "data/data_online_text_changes.h"
 
 namespace {
 
@@ -158,7 +159,8 @@ AuthSession::AuthSession(UserId userId)
 , _api(std::make_unique<ApiWrap>())
 , _calls(std::make_unique<Calls::Instance>())
 , _downloader(std::make_unique<Storage::Downloader>())
-, _notifications(std::make_unique<Window::Notifications::System>(this)) {
+, _notifications(std::make_unique<Window::Notifications::System>(this))
+, _onlineTextChanges(std::make_unique<Data::OnlineTextChanges>()) {
 	Expects(_userId != 0);
 	_saveDataTimer.setCallback([this] {
 		Local::writeUserSettings();
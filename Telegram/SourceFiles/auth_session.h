@@ -37,6 +37,10 @@ namespace Calls {
 class Instance;
 } // namespace Calls
 
+namespace Data {
+class OnlineTextChanges;
+} // namespace Data
+
 namespace ChatHelpers {
 enum class SelectorTab;
 } // namespace ChatHelpers
@@ -182,6 +186,10 @@ public:
 		return *_calls;
 	}
 
+	Data::OnlineTextChanges &onlineTextChanges() {
+		return *_onlineTextChanges;
+	}
+
 	void checkAutoLock();
 	void checkAutoLockIn(TimeMs time);
 
@@ -199,5 +207,6 @@ private:
 	const std::unique_ptr<Calls::Instance> _calls;
 	const std::unique_ptr<Storage::Downloader> _downloader;
 	const std::unique_ptr<Window::Notifications::System> _notifications;
+	const std::unique_ptr<Data::OnlineTextChanges> _onlineTextChanges;
 
 };
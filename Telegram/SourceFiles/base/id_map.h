@@ -0,0 +1,240 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace base {
+
+// Open addressing map from integer ids to non-null pointers.
+//
+// Keys and values live in one flat array with linear probing, so a lookup
+// usually touches a single cache line instead of walking QHash / QMap nodes
+// allocated one per entry. Removal shifts the following entries back, so
+// there are no tombstones and lookups stay short after many removals.
+//
+// Empty slots are marked by nullptr values, so nullptr can't be inserted.
+// Any insert or remove invalidates iterators.
+template <typename Key, typename Value>
+class IdMap {
+	static_assert(std::is_integral<Key>::value, "IdMap keys must be integers.");
+	static_assert(std::is_pointer<Value>::value, "IdMap values must be pointers.");
+
+	struct Slot {
+		Key key = Key();
+		Value value = nullptr;
+	};
+
+public:
+	IdMap() = default;
+	IdMap(const IdMap &other) = delete;
+	IdMap &operator=(const IdMap &other) = delete;
+
+	class const_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Value;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Value*;
+		using reference = const Value&;
+
+		const Key &key() const {
+			return _slot->key;
+		}
+		const Value &value() const {
+			return _slot->value;
+		}
+		const Value &operator*() const {
+			return _slot->value;
+		}
+		const_iterator &operator++() {
+			++_slot;
+			skipEmpty();
+			return *this;
+		}
+		const_iterator operator++(int) {
+			auto result = *this;
+			++*this;
+			return result;
+		}
+		bool operator==(const const_iterator &other) const {
+			return (_slot == other._slot);
+		}
+		bool operator!=(const const_iterator &other) const {
+			return (_slot != other._slot);
+		}
+
+	private:
+		friend class IdMap;
+		const_iterator(const Slot *slot, const Slot *end) : _slot(slot), _end(end) {
+			skipEmpty();
+		}
+		void skipEmpty() {
+			while (_slot != _end && !_slot->value) {
+				++_slot;
+			}
+		}
+
+		const Slot *_slot = nullptr;
+		const Slot *_end = nullptr;
+
+	};
+
+	const_iterator begin() const {
+		return const_iterator(_slots.get(), slotsEnd());
+	}
+	const_iterator end() const {
+		return const_iterator(slotsEnd(), slotsEnd());
+	}
+	const_iterator cbegin() const {
+		return begin();
+	}
+	const_iterator cend() const {
+		return end();
+	}
+
+	int size() const {
+		return _size;
+	}
+	bool empty() const {
+		return (_size == 0);
+	}
+	bool isEmpty() const {
+		return empty();
+	}
+
+	// Returns nullptr if there is no such key.
+	Value value(Key key) const {
+		if (!_size) {
+			return nullptr;
+		}
+		for (auto index = indexOf(key); _slots[index].value; index = (index + 1) & _mask) {
+			if (_slots[index].key == key) {
+				return _slots[index].value;
+			}
+		}
+		return nullptr;
+	}
+	bool contains(Key key) const {
+		return (value(key) != nullptr);
+	}
+
+	// Replaces the value if the key is already present.
+	void insert(Key key, Value value) {
+		Expects(value != nullptr);
+
+		if ((_size + 1) * 4 > capacity() * 3) {
+			rehash(capacity() ? (capacity() * 2) : kMinCapacity);
+		}
+		auto index = indexOf(key);
+		for (; _slots[index].value; index = (index + 1) & _mask) {
+			if (_slots[index].key == key) {
+				_slots[index].value = value;
+				return;
+			}
+		}
+		_slots[index].key = key;
+		_slots[index].value = value;
+		++_size;
+	}
+
+	// Returns the removed value or nullptr if there was no such key.
+	Value take(Key key) {
+		if (!_size) {
+			return nullptr;
+		}
+		auto index = indexOf(key);
+		for (; _slots[index].value; index = (index + 1) & _mask) {
+			if (_slots[index].key == key) {
+				auto result = _slots[index].value;
+				removeAt(index);
+				return result;
+			}
+		}
+		return nullptr;
+	}
+	bool remove(Key key) {
+		return (take(key) != nullptr);
+	}
+
+	void clear() {
+		_slots = nullptr;
+		_mask = 0;
+		_shift = 0;
+		_size = 0;
+	}
+
+private:
+	static constexpr auto kMinCapacity = 16;
+
+	int capacity() const {
+		return _slots ? (_mask + 1) : 0;
+	}
+	const Slot *slotsEnd() const {
+		return _slots.get() + capacity();
+	}
+
+	// Fibonacci hashing spreads sequential ids over the whole table.
+	int indexOf(Key key) const {
+		auto hash = static_cast<uint64>(key) * 0x9E3779B97F4A7C15ULL;
+		return static_cast<int>(hash >> _shift);
+	}
+
+	void rehash(int newCapacity) {
+		auto oldCapacity = capacity();
+		auto oldSlots = std::move(_slots);
+
+		_slots = std::make_unique<Slot[]>(newCapacity);
+		_mask = newCapacity - 1;
+		_shift = 64;
+		for (auto i = newCapacity; i > 1; i >>= 1) {
+			--_shift;
+		}
+		for (auto i = 0; i != oldCapacity; ++i) {
+			if (oldSlots[i].value) {
+				auto index = indexOf(oldSlots[i].key);
+				while (_slots[index].value) {
+					index = (index + 1) & _mask;
+				}
+				_slots[index] = oldSlots[i];
+			}
+		}
+	}
+
+	void removeAt(int hole) {
+		for (auto next = (hole + 1) & _mask; _slots[next].value; next = (next + 1) & _mask) {
+			// Move the entry back if the hole is between its ideal slot and its current one.
+			auto ideal = indexOf(_slots[next].key);
+			if (((next - ideal) & _mask) >= ((next - hole) & _mask)) {
+				_slots[hole] = _slots[next];
+				hole = next;
+			}
+		}
+		_slots[hole] = Slot();
+		--_size;
+	}
+
+	std::unique_ptr<Slot[]> _slots;
+	int _mask = 0;
+	int _shift = 0;
+	int _size = 0;
+
+};
+
+} // namespace base
@@ -121,6 +121,10 @@ public:
 		return _data->append(std::move(handler));
 	}
 
+	bool empty() const {
+		return !_data;
+	}
+
 private:
 	QSharedPointer<ObservableData<EventType, Handler>> _data;
 
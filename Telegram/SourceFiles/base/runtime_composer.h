@@ -20,6 +20,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 */
 #pragma once
 
+#include "base/slab_allocator.h"
+
 class RuntimeComposer;
 typedef void(*RuntimeComponentConstruct)(void *location, RuntimeComposer *composer);
 typedef void(*RuntimeComponentDestruct)(void *location);
@@ -153,7 +155,7 @@ public:
 			const RuntimeComposerMetadata *meta = GetRuntimeComposerMetadata(mask);
 			int size = sizeof(meta) + meta->size;
 
-			auto data = operator new(size);
+			auto data = base::SlabAllocate(size);
 			t_assert(data != nullptr);
 
 			_data = data;
@@ -192,7 +194,7 @@ public:
 					RuntimeComponentWraps[i].Destruct(_dataptrunsafe(offset));
 				}
 			}
-			operator delete(_data);
+			base::SlabFree(_data, sizeof(meta) + meta->size);
 		}
 	}
 
@@ -0,0 +1,162 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "base/slab_allocator.h"
+
+namespace base {
+namespace {
+
+constexpr auto kGranularity = std::size_t(16);
+constexpr auto kMaxBlockSize = std::size_t(1024);
+constexpr auto kSizeClassesCount = kMaxBlockSize / kGranularity;
+constexpr auto kChunkSize = std::size_t(64 * 1024);
+
+class SlabPool {
+public:
+	void *allocate(std::size_t size) {
+		auto sizeClass = sizeClassFor(size);
+		if (!_free[sizeClass]) {
+			refill(sizeClass);
+		}
+		auto result = _free[sizeClass];
+		_free[sizeClass] = result->next;
+		return result;
+	}
+
+	void free(void *pointer, std::size_t size) {
+		auto sizeClass = sizeClassFor(size);
+		auto block = static_cast<FreeBlock*>(pointer);
+		block->next = _free[sizeClass];
+		_free[sizeClass] = block;
+	}
+
+	std::size_t trim() {
+		if (_chunks.empty()) {
+			return 0;
+		}
+		std::sort(_chunks.begin(), _chunks.end(), [](const Chunk &a, const Chunk &b) {
+			return a.data.get() < b.data.get();
+		});
+		auto chunkIndex = [this](FreeBlock *block) {
+			auto pointer = reinterpret_cast<char*>(block);
+			auto i = std::upper_bound(_chunks.cbegin(), _chunks.cend(), pointer, [](char *pointer, const Chunk &chunk) {
+				return pointer < chunk.data.get();
+			});
+			return std::size_t(i - _chunks.cbegin() - 1);
+		};
+
+		auto freeCounts = std::vector<std::size_t>(_chunks.size(), 0);
+		for (auto block : _free) {
+			for (; block; block = block->next) {
+				++freeCounts[chunkIndex(block)];
+			}
+		}
+		auto released = std::vector<bool>(_chunks.size(), false);
+		auto releasedCount = std::size_t(0);
+		for (auto i = std::size_t(0), count = _chunks.size(); i != count; ++i) {
+			auto blockSize = (_chunks[i].sizeClass + 1) * kGranularity;
+			if (freeCounts[i] == kChunkSize / blockSize) {
+				released[i] = true;
+				++releasedCount;
+			}
+		}
+		if (!releasedCount) {
+			return 0;
+		}
+
+		// Unlink the blocks of the released chunks from the free lists.
+		for (auto &first : _free) {
+			auto link = &first;
+			while (auto block = *link) {
+				if (released[chunkIndex(block)]) {
+					*link = block->next;
+				} else {
+					link = &block->next;
+				}
+			}
+		}
+		auto kept = std::size_t(0);
+		for (auto i = std::size_t(0), count = _chunks.size(); i != count; ++i) {
+			if (!released[i]) {
+				_chunks[kept++] = std::move(_chunks[i]);
+			}
+		}
+		_chunks.resize(kept);
+		return releasedCount * kChunkSize;
+	}
+
+private:
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+	struct Chunk {
+		std::unique_ptr<char[]> data;
+		std::size_t sizeClass;
+	};
+
+	static std::size_t sizeClassFor(std::size_t size) {
+		return (size - 1) / kGranularity;
+	}
+
+	void refill(std::size_t sizeClass) {
+		auto blockSize = (sizeClass + 1) * kGranularity;
+		auto chunk = std::make_unique<char[]>(kChunkSize);
+		for (auto offset = kChunkSize - (kChunkSize % blockSize); offset != 0;) {
+			offset -= blockSize;
+			free(chunk.get() + offset, blockSize);
+		}
+		_chunks.push_back({ std::move(chunk), sizeClass });
+	}
+
+	std::array<FreeBlock*, kSizeClassesCount> _free = { { nullptr } };
+	std::vector<Chunk> _chunks;
+
+};
+
+SlabPool &Pool() {
+	// Leaked on purpose, so that static objects can free blocks on exit.
+	static auto result = new SlabPool();
+	return *result;
+}
+
+} // namespace
+
+void *SlabAllocate(std::size_t size) {
+	if (!size || size > kMaxBlockSize) {
+		return ::operator new(size);
+	}
+	return Pool().allocate(size);
+}
+
+void SlabFree(void *pointer, std::size_t size) {
+	if (!pointer) {
+		return;
+	} else if (!size || size > kMaxBlockSize) {
+		::operator delete(pointer);
+		return;
+	}
+	Pool().free(pointer, size);
+}
+
+std::size_t SlabTrim() {
+	return Pool().trim();
+}
+
+} // namespace base
@@ -0,0 +1,43 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace base {
+
+// Allocator for small objects that are created and destroyed in big
+// numbers, like history items and their runtime components.
+//
+// Memory is taken from the system in large chunks, each split into blocks
+// of one size class. Freed blocks go to the free list of their size class
+// and are reused by the next allocation of the same size, so creating a
+// slice of messages doesn't call malloc for each item and component.
+//
+// Chunks are returned to the system only by SlabTrim(), when all of their
+// blocks are free. Not thread-safe, all the users (history items, layout
+// items and media) live in the main thread.
+void *SlabAllocate(std::size_t size);
+void SlabFree(void *pointer, std::size_t size);
+
+// Walks all the free lists, call it after destroying many objects.
+// Returns the count of bytes given back to the system.
+std::size_t SlabTrim();
+
+} // namespace base
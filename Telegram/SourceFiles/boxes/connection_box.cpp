@@ -256,9 +256,8 @@ void AutoDownloadBox::onSave() {
 		bool enabledGroups = ((cAutoDownloadPhoto() & dbiadNoGroups) && !(autoDownloadPhoto & dbiadNoGroups));
 		cSetAutoDownloadPhoto(autoDownloadPhoto);
 		if (enabledPrivate || enabledGroups) {
-			const PhotosData &data(App::photosData());
-			for (PhotosData::const_iterator i = data.cbegin(), e = data.cend(); i != e; ++i) {
-				i.value()->automaticLoadSettingsChanged();
+			for (auto photo : App::photosData()) {
+				photo->automaticLoadSettingsChanged();
 			}
 		}
 		changed = true;
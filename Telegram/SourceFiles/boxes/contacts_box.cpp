@@ -812,6 +812,7 @@ void ContactsBox::Inner::peerUpdated(PeerData *peer) {
 		}
 		if (inited) {
 			_filter += 'a';
+			_filterSearchState.invalidate();
 			updateFilter(_lastQuery);
 		}
 		update();
@@ -1539,22 +1540,10 @@ void ContactsBox::Inner::updateSelection() {
 
 void ContactsBox::Inner::updateFilter(QString filter) {
 	_lastQuery = filter.toLower().trimmed();
-	filter = textSearchKey(filter);
 
 	_time = unixtime();
-	QStringList f;
-	if (!filter.isEmpty()) {
-		QStringList filterList = filter.split(cWordSplit(), QString::SkipEmptyParts);
-		int l = filterList.size();
-
-		f.reserve(l);
-		for (int i = 0; i < l; ++i) {
-			QString filterName = filterList[i].trimmed();
-			if (filterName.isEmpty()) continue;
-			f.push_back(filterName);
-		}
-		filter = f.join(' ');
-	}
+	auto words = Dialogs::SearchWords(textSearchKey(filter));
+	filter = words.join(' ');
 	if (_filter != filter) {
 		_filter = filter;
 
@@ -1569,70 +1558,32 @@ void ContactsBox::Inner::updateFilter(QString filter) {
 		_searchedSelected = -1;
 		setSearchedPressed(-1);
 		if (_filter.isEmpty()) {
+			_filterSearchState.invalidate();
 			refresh();
 		} else {
 			if (!_addContactLnk->isHidden()) _addContactLnk->hide();
 			if (!_allAdmins->isHidden()) _allAdmins->hide();
-			QStringList::const_iterator fb = f.cbegin(), fe = f.cend(), fi;
 
-			_filtered.clear();
-			if (!f.isEmpty()) {
-				const Dialogs::List *toFilter = nullptr;
-				if (!_contacts->isEmpty()) {
-					for (fi = fb; fi != fe; ++fi) {
-						auto found = _contacts->filtered(fi->at(0));
-						if (found->isEmpty()) {
-							toFilter = nullptr;
-							break;
-						}
-						if (!toFilter || toFilter->size() > found->size()) {
-							toFilter = found;
-						}
-					}
-				}
-				if (toFilter) {
-					_filtered.reserve(toFilter->size());
-					for_const (auto row, *toFilter) {
-						const PeerData::Names &names(row->history()->peer->names);
-						PeerData::Names::const_iterator nb = names.cbegin(), ne = names.cend(), ni;
-						for (fi = fb; fi != fe; ++fi) {
-							QString filterName(*fi);
-							for (ni = nb; ni != ne; ++ni) {
-								if (ni->startsWith(*fi)) {
-									break;
-								}
-							}
-							if (ni == ne) {
-								break;
-							}
-						}
-						if (fi == fe) {
-							row->attached = nullptr;
-							_filtered.push_back(row);
-						}
-					}
+			auto listChanges = _contacts->changesCount();
+			if (_filterSearchState.canNarrow(words, listChanges)) {
+				Dialogs::NarrowSearchResults(_filtered, words, [](Dialogs::Row *row) {
+					return row->history()->peer;
+				});
+			} else {
+				_filtered.clear();
+				Dialogs::AppendSearchResults(_filtered, *_contacts, words);
+				for_const (auto row, _filtered) {
+					row->attached = nullptr;
 				}
-
-				_byUsernameFiltered.reserve(_byUsername.size());
-				d_byUsernameFiltered.reserve(d_byUsername.size());
-				for (int32 i = 0, l = _byUsername.size(); i < l; ++i) {
-					const PeerData::Names &names(_byUsername[i]->names);
-					PeerData::Names::const_iterator nb = names.cbegin(), ne = names.cend(), ni;
-					for (fi = fb; fi != fe; ++fi) {
-						QString filterName(*fi);
-						for (ni = nb; ni != ne; ++ni) {
-							if (ni->startsWith(*fi)) {
-								break;
-							}
-						}
-						if (ni == ne) {
-							break;
-						}
-					}
-					if (fi == fe) {
-						_byUsernameFiltered.push_back(_byUsername[i]);
-						d_byUsernameFiltered.push_back(d_byUsername[i]);
-					}
+			}
+			_filterSearchState.remember(words, listChanges);
+
+			_byUsernameFiltered.reserve(_byUsername.size());
+			d_byUsernameFiltered.reserve(d_byUsername.size());
+			for (int i = 0, l = _byUsername.size(); i < l; ++i) {
+				if (Dialogs::PeerMatchesSearchWords(_byUsername[i], words)) {
+					_byUsernameFiltered.push_back(_byUsername[i]);
+					d_byUsernameFiltered.push_back(d_byUsername[i]);
 				}
 			}
 			if (!_filtered.isEmpty()) {
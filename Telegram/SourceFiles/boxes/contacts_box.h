@@ -24,6 +24,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "core/single_timer.h"
 #include "ui/effects/round_checkbox.h"
 #include "boxes/members_box.h"
+#include "dialogs/dialogs_search.h"
 
 namespace Dialogs {
 class Row;
@@ -304,6 +305,7 @@ private:
 	QString _filter;
 	using FilteredDialogs = QVector<Dialogs::Row*>;
 	FilteredDialogs _filtered;
+	Dialogs::SearchState _filterSearchState;
 	int _filteredSelected = -1;
 	int _filteredPressed = -1;
 	bool _mouseSelection = false;
@@ -475,6 +475,7 @@ void PeerListBox::Inner::addToSearchIndex(Row *row) {
 	}
 
 	removeFromSearchIndex(row);
+	_filterSearchState.invalidate();
 	row->setNameFirstChars(row->peer()->chars);
 	for_const (auto ch, row->nameFirstChars()) {
 		_searchIndex[ch].push_back(row);
@@ -484,6 +485,7 @@ void PeerListBox::Inner::addToSearchIndex(Row *row) {
 void PeerListBox::Inner::removeFromSearchIndex(Row *row) {
 	auto &nameFirstChars = row->nameFirstChars();
 	if (!nameFirstChars.empty()) {
+		_filterSearchState.invalidate();
 		for_const (auto ch, row->nameFirstChars()) {
 			auto it = _searchIndex.find(ch);
 			if (it != _searchIndex.cend()) {
@@ -899,7 +901,7 @@ void PeerListBox::Inner::checkScrollForPreload() {
 }
 
 void PeerListBox::Inner::searchQueryChanged(QString query) {
-	auto searchWordsList = query.isEmpty() ? QStringList() : query.split(cWordSplit(), QString::SkipEmptyParts);
+	auto searchWordsList = Dialogs::SearchWords(query);
 	if (!searchWordsList.isEmpty()) {
 		query = searchWordsList.join(' ');
 	}
@@ -908,9 +910,16 @@ void PeerListBox::Inner::searchQueryChanged(QString query) {
 		setPressed(Selected());
 
 		_searchQuery = query;
-		_filterResults.clear();
 		clearGlobalSearchRows();
-		if (!searchWordsList.isEmpty()) {
+		if (searchWordsList.isEmpty()) {
+			_filterResults.clear();
+			_filterSearchState.invalidate();
+		} else if (_filterSearchState.canNarrow(searchWordsList, 0)) {
+			Dialogs::NarrowSearchResults(_filterResults, searchWordsList, [](Row *row) {
+				return row->peer();
+			});
+		} else {
+			_filterResults.clear();
 			auto minimalList = (const std::vector<Row*>*)nullptr;
 			for_const (auto &searchWord, searchWordsList) {
 				auto searchWordStart = searchWord[0].toLower();
@@ -924,31 +933,17 @@ void PeerListBox::Inner::searchQueryChanged(QString query) {
 				}
 			}
 			if (minimalList) {
-				auto searchWordInNames = [](PeerData *peer, const QString &searchWord) {
-					for_const (auto &nameWord, peer->names) {
-						if (nameWord.startsWith(searchWord)) {
-							return true;
-						}
-					}
-					return false;
-				};
-				auto allSearchWordsInNames = [searchWordInNames, &searchWordsList](PeerData *peer) {
-					for_const (auto &searchWord, searchWordsList) {
-						if (!searchWordInNames(peer, searchWord)) {
-							return false;
-						}
-					}
-					return true;
-				};
-
 				_filterResults.reserve(minimalList->size());
 				for_const (auto row, *minimalList) {
-					if (allSearchWordsInNames(row->peer())) {
+					if (Dialogs::PeerMatchesSearchWords(row->peer(), searchWordsList)) {
 						_filterResults.push_back(row);
 					}
 				}
 			}
 		}
+		if (!searchWordsList.isEmpty()) {
+			_filterSearchState.remember(searchWordsList, 0);
+		}
 		if (_searchMode == SearchMode::Global) {
 			_globalSearchRequestId = 0;
 			needGlobalSearch();
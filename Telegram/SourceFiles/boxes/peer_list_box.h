@@ -22,6 +22,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 #include "boxes/abstract_box.h"
 #include "mtproto/sender.h"
+#include "dialogs/dialogs_search.h"
 
 namespace Ui {
 class RippleAnimation;
@@ -307,6 +308,7 @@ public:
 		for (auto &searchEntity : _searchIndex) {
 			callback(searchEntity.second.begin(), searchEntity.second.end());
 		}
+		_filterSearchState.invalidate();
 		refreshIndices();
 	}
 
@@ -420,6 +422,7 @@ private:
 	std::map<QChar, std::vector<Row*>> _searchIndex;
 	QString _searchQuery;
 	std::vector<Row*> _filterResults;
+	Dialogs::SearchState _filterSearchState;
 
 	object_ptr<Ui::FlatLabel> _about = { nullptr };
 	object_ptr<Ui::FlatLabel> _searchNoResults = { nullptr };
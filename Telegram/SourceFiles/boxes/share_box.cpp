@@ -674,21 +674,9 @@ bool ShareBox::Inner::hasSelected() const {
 
 void ShareBox::Inner::updateFilter(QString filter) {
 	_lastQuery = filter.toLower().trimmed();
-	filter = textSearchKey(filter);
-
-	QStringList f;
-	if (!filter.isEmpty()) {
-		QStringList filterList = filter.split(cWordSplit(), QString::SkipEmptyParts);
-		int l = filterList.size();
-
-		f.reserve(l);
-		for (int i = 0; i < l; ++i) {
-			QString filterName = filterList[i].trimmed();
-			if (filterName.isEmpty()) continue;
-			f.push_back(filterName);
-		}
-		filter = f.join(' ');
-	}
+
+	auto words = Dialogs::SearchWords(textSearchKey(filter));
+	filter = words.join(' ');
 	if (_filter != filter) {
 		_filter = filter;
 
@@ -699,47 +687,19 @@ void ShareBox::Inner::updateFilter(QString filter) {
 		d_byUsernameFiltered.clear();
 
 		if (_filter.isEmpty()) {
+			_filterSearchState.invalidate();
 			refresh();
 		} else {
-			QStringList::const_iterator fb = f.cbegin(), fe = f.cend(), fi;
-
-			_filtered.clear();
-			if (!f.isEmpty()) {
-				const Dialogs::List *toFilter = nullptr;
-				if (!_chatsIndexed->isEmpty()) {
-					for (fi = fb; fi != fe; ++fi) {
-						auto found = _chatsIndexed->filtered(fi->at(0));
-						if (found->isEmpty()) {
-							toFilter = nullptr;
-							break;
-						}
-						if (!toFilter || toFilter->size() > found->size()) {
-							toFilter = found;
-						}
-					}
-				}
-				if (toFilter) {
-					_filtered.reserve(toFilter->size());
-					for_const (auto row, *toFilter) {
-						auto &names = row->history()->peer->names;
-						PeerData::Names::const_iterator nb = names.cbegin(), ne = names.cend(), ni;
-						for (fi = fb; fi != fe; ++fi) {
-							auto filterName = *fi;
-							for (ni = nb; ni != ne; ++ni) {
-								if (ni->startsWith(*fi)) {
-									break;
-								}
-							}
-							if (ni == ne) {
-								break;
-							}
-						}
-						if (fi == fe) {
-							_filtered.push_back(row);
-						}
-					}
-				}
+			auto listChanges = _chatsIndexed->changesCount();
+			if (_filterSearchState.canNarrow(words, listChanges)) {
+				Dialogs::NarrowSearchResults(_filtered, words, [](Dialogs::Row *row) {
+					return row->history()->peer;
+				});
+			} else {
+				_filtered.clear();
+				Dialogs::AppendSearchResults(_filtered, *_chatsIndexed, words);
 			}
+			_filterSearchState.remember(words, listChanges);
 			refresh();
 
 			_searching = true;
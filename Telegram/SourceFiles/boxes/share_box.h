@@ -23,6 +23,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "boxes/abstract_box.h"
 #include "base/observer.h"
 #include "ui/effects/round_checkbox.h"
+#include "dialogs/dialogs_search.h"
 
 namespace Dialogs {
 class Row;
@@ -197,6 +198,7 @@ private:
 	QString _filter;
 	using FilteredDialogs = QVector<Dialogs::Row*>;
 	FilteredDialogs _filtered;
+	Dialogs::SearchState _filterSearchState;
 
 	using DataMap = QMap<PeerData*, Chat*>;
 	DataMap _dataMap;
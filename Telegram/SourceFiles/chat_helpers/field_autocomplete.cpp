@@ -28,6 +28,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "styles/style_widgets.h"
 #include "styles/style_chat_helpers.h"
 #include "auth_session.h"
+#include "observer_peer.h"
+#include "chat_helpers/stickers.h"
 
 FieldAutocomplete::FieldAutocomplete(QWidget *parent) : TWidget(parent)
 , _scroll(this, st::mentionScroll) {
@@ -48,6 +50,14 @@ FieldAutocomplete::FieldAutocomplete(QWidget *parent) : TWidget(parent)
 	hide();
 
 	connect(_scroll, SIGNAL(geometryChanged()), _inner, SLOT(onParentGeometryChanged()));
+
+	auto observeEvents = Notify::PeerUpdate::Flag::NameChanged
+		| Notify::PeerUpdate::Flag::UsernameChanged;
+	subscribe(Notify::PeerUpdated(), Notify::PeerUpdatedHandler(observeEvents, [this](const Notify::PeerUpdate &update) {
+		if (update.peer->isUser()) {
+			_mentionIndex.invalidate();
+		}
+	}));
 }
 
 void FieldAutocomplete::paintEvent(QPaintEvent *e) {
@@ -140,6 +150,16 @@ inline int indexOfInFirstN(const T &v, const U &elem, int last) {
 }
 }
 
+std::vector<UserData*> FieldAutocomplete::findMentions(const std::vector<UserData*> &users) {
+	// Name parts are accent folded and lowercase, see PeerData::fillNames().
+	auto result = _mentionIndex.find(users, textAccentFold(_filter).toLower());
+	auto isExactUsername = [this](UserData *user) {
+		return (user->username.compare(_filter, Qt::CaseInsensitive) == 0);
+	};
+	result.erase(std::remove_if(result.begin(), result.end(), isExactUsername), result.end());
+	return result;
+}
+
 void FieldAutocomplete::updateFiltered(bool resetScroll) {
 	int32 now = unixtime(), recentInlineBots = 0;
 	internal::MentionRows mrows;
@@ -147,30 +167,7 @@ void FieldAutocomplete::updateFiltered(bool resetScroll) {
 	internal::BotCommandRows brows;
 	StickerPack srows;
 	if (_emoji) {
-		auto original = _emoji->original();
-		QMap<uint64, uint64> setsToRequest;
-		auto &sets = Global::RefStickerSets();
-		auto &order = Global::StickerSetsOrder();
-		for (auto i = 0, l = order.size(); i != l; ++i) {
-			auto it = sets.find(order[i]);
-			if (it != sets.cend()) {
-				if (it->emoji.isEmpty()) {
-					setsToRequest.insert(it->id, it->access);
-					it->flags |= MTPDstickerSet_ClientFlag::f_not_loaded;
-				} else if (!(it->flags & MTPDstickerSet::Flag::f_archived)) {
-					auto i = it->emoji.constFind(original);
-					if (i != it->emoji.cend()) {
-						srows += *i;
-					}
-				}
-			}
-		}
-		if (!setsToRequest.isEmpty() && App::api()) {
-			for (QMap<uint64, uint64>::const_iterator i = setsToRequest.cbegin(), e = setsToRequest.cend(); i != e; ++i) {
-				App::api()->scheduleStickerSetRequest(i.key(), i.value());
-			}
-			App::api()->requestStickerSets();
-		}
+		srows = Stickers::GetListByEmoji(_emoji);
 	} else if (_type == Type::Mentions) {
 		int maxListSize = _addInlineBots ? cRecentInlineBots().size() : 0;
 		if (_chat) {
@@ -203,6 +200,14 @@ void FieldAutocomplete::updateFiltered(bool resetScroll) {
 		};
 
 		bool listAllSuggestions = _filter.isEmpty();
+		auto filterPassedByIndex = [this](auto &&users) {
+			auto list = std::vector<UserData*>();
+			list.reserve(users.size());
+			for (auto i = users.cbegin(), e = users.cend(); i != e; ++i) {
+				list.push_back(*i);
+			}
+			return findMentions(list);
+		};
 		if (_addInlineBots) {
 			for_const (auto user, cRecentInlineBots()) {
 				if (user->isInaccessible()) continue;
@@ -217,12 +222,19 @@ void FieldAutocomplete::updateFiltered(bool resetScroll) {
 			if (_chat->noParticipantInfo()) {
 				if (App::api()) App::api()->requestFullPeer(_chat);
 			} else if (!_chat->participants.isEmpty()) {
-				for (auto i = _chat->participants.cbegin(), e = _chat->participants.cend(); i != e; ++i) {
-					auto user = i.key();
-					if (user->isInaccessible()) continue;
-					if (!listAllSuggestions && filterNotPassedByName(user)) continue;
-					if (indexOfInFirstN(mrows, user, recentInlineBots) >= 0) continue;
+				auto addParticipant = [&](UserData *user) {
+					if (user->isInaccessible()) return;
+					if (indexOfInFirstN(mrows, user, recentInlineBots) >= 0) return;
 					ordered.insertMulti(App::onlineForSort(user, now), user);
+				};
+				if (listAllSuggestions) {
+					for (auto i = _chat->participants.cbegin(), e = _chat->participants.cend(); i != e; ++i) {
+						addParticipant(i.key());
+					}
+				} else {
+					for (auto user : filterPassedByIndex(_chat->participants.keys())) {
+						addParticipant(user);
+					}
 				}
 			}
 			for_const (auto user, _chat->lastAuthors) {
@@ -245,12 +257,21 @@ void FieldAutocomplete::updateFiltered(bool resetScroll) {
 			if (_channel->mgInfo->lastParticipants.isEmpty() || _channel->lastParticipantsCountOutdated()) {
 				if (App::api()) App::api()->requestLastParticipants(_channel);
 			} else {
-				mrows.reserve(mrows.size() + _channel->mgInfo->lastParticipants.size());
-				for_const (auto user, _channel->mgInfo->lastParticipants) {
-					if (user->isInaccessible()) continue;
-					if (!listAllSuggestions && filterNotPassedByName(user)) continue;
-					if (indexOfInFirstN(mrows, user, recentInlineBots) >= 0) continue;
+				auto &participants = _channel->mgInfo->lastParticipants;
+				auto addParticipant = [&](UserData *user) {
+					if (user->isInaccessible()) return;
+					if (indexOfInFirstN(mrows, user, recentInlineBots) >= 0) return;
 					mrows.push_back(user);
+				};
+				if (listAllSuggestions) {
+					mrows.reserve(mrows.size() + participants.size());
+					for_const (auto user, participants) {
+						addParticipant(user);
+					}
+				} else {
+					for (auto user : filterPassedByIndex(participants)) {
+						addParticipant(user);
+					}
 				}
 			}
 		}
@@ -519,6 +540,49 @@ FieldAutocomplete::~FieldAutocomplete() {
 
 namespace internal {
 
+void MentionIndex::invalidate() {
+	_users.clear();
+	_words.clear();
+}
+
+std::vector<UserData*> MentionIndex::find(const std::vector<UserData*> &users, const QString &prefix) {
+	if (_users != users) {
+		rebuild(users);
+	}
+	auto indices = std::vector<int>();
+	auto from = std::lower_bound(_words.cbegin(), _words.cend(), prefix, [](const std::pair<QString, int> &word, const QString &prefix) {
+		return (word.first < prefix);
+	});
+	for (auto i = from, e = _words.cend(); i != e && i->first.startsWith(prefix); ++i) {
+		indices.push_back(i->second);
+	}
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+	auto result = std::vector<UserData*>();
+	result.reserve(indices.size());
+	for (auto index : indices) {
+		result.push_back(_users[index]);
+	}
+	return result;
+}
+
+void MentionIndex::rebuild(const std::vector<UserData*> &users) {
+	_users = users;
+	_words.clear();
+	for (auto i = 0, count = int(_users.size()); i != count; ++i) {
+		for_const (auto &namePart, _users[i]->names) {
+			_words.push_back(std::make_pair(namePart, i));
+		}
+
+		// Name parts are split by '_' as well, so "@john_d" must match the whole username.
+		if (!_users[i]->username.isEmpty()) {
+			_words.push_back(std::make_pair(_users[i]->username.toLower(), i));
+		}
+	}
+	std::sort(_words.begin(), _words.end());
+}
+
 FieldAutocompleteInner::FieldAutocompleteInner(FieldAutocomplete *parent, MentionRows *mrows, HashtagRows *hrows, BotCommandRows *brows, StickerPack *srows)
 : _parent(parent)
 , _mrows(mrows)
@@ -34,9 +34,28 @@ using BotCommandRows = QList<QPair<UserData*, const BotCommand*>>;
 
 class FieldAutocompleteInner;
 
+// Sorted name parts and usernames of the chat members, so that the mention
+// suggestions are found by a binary search instead of checking all the members.
+class MentionIndex {
+public:
+	void invalidate();
+
+	// Rebuilds the index if the users list changed since the last call.
+	// Returns the users having a name part or a username that starts with
+	// the prefix in the same order as they are in the list.
+	std::vector<UserData*> find(const std::vector<UserData*> &users, const QString &prefix);
+
+private:
+	void rebuild(const std::vector<UserData*> &users);
+
+	std::vector<UserData*> _users;
+	std::vector<std::pair<QString, int>> _words;
+
+};
+
 } // namespace internal
 
-class FieldAutocomplete final : public TWidget {
+class FieldAutocomplete final : public TWidget, private base::Subscriber {
 	Q_OBJECT
 
 public:
@@ -99,6 +118,7 @@ private:
 
 	void updateFiltered(bool resetScroll = false);
 	void recount(bool resetScroll = false);
+	std::vector<UserData*> findMentions(const std::vector<UserData*> &users);
 
 	QPixmap _cache;
 	internal::MentionRows _mrows;
@@ -123,6 +143,7 @@ private:
 	};
 	Type _type = Type::Mentions;
 	QString _filter;
+	internal::MentionIndex _mentionIndex;
 	QRect _boundings;
 	bool _addInlineBots;
 
@@ -39,6 +39,7 @@ constexpr auto kSaveChosenTabTimeout = 1000;
 constexpr auto kSearchRequestDelay = 400;
 constexpr auto kStickersPanelPerRow = Stickers::kPanelPerRow;
 constexpr auto kInlineItemsMaxPerRow = 5;
+constexpr auto kPreloadAfterScrollTimeout = 100;
 constexpr auto kSearchBotUsername = str_const("gif");
 
 } // namespace
@@ -161,6 +162,7 @@ void GifsListWidget::setVisibleTopBottom(int visibleTop, int visibleBottom) {
 	Inner::setVisibleTopBottom(visibleTop, visibleBottom);
 	if (top != getVisibleTop()) {
 		_lastScrolled = getms();
+		_updateInlineItems.start(kPreloadAfterScrollTimeout);
 	}
 	checkLoadMore();
 }
@@ -427,7 +429,6 @@ bool GifsListWidget::inlineRowsAddItem(DocumentData *savedGif, InlineResult *res
 	}
 	if (!layout) return false;
 
-	layout->preload();
 	if (inlineRowFinalize(row, sumWidth, layout->isFullLine())) {
 		layout->setPosition(_rows.size() * MatrixRowShift);
 	}
@@ -596,10 +597,22 @@ GifsListWidget::Row &GifsListWidget::layoutInlineRow(Row &row, int32 sumWidth) {
 }
 
 void GifsListWidget::preloadImages() {
+	// Only the rows around the visible area, others are preloaded when scrolled to.
+	auto visibleHeight = qMax(getVisibleBottom() - getVisibleTop(), int(st::emojiPanMaxHeight));
+	auto preloadTop = getVisibleTop() - visibleHeight;
+	auto preloadBottom = getVisibleTop() + 2 * visibleHeight;
+	auto top = int(st::stickerPanPadding);
 	for (auto row = 0, rows = _rows.size(); row != rows; ++row) {
-		for (auto col = 0, cols = _rows[row].items.size(); col != cols; ++col) {
-			_rows[row].items[col]->preload();
+		auto &inlineRow = _rows[row];
+		if (top >= preloadBottom) {
+			break;
+		}
+		if (top + inlineRow.height > preloadTop) {
+			for (auto col = 0, cols = inlineRow.items.size(); col != cols; ++col) {
+				inlineRow.items[col]->preload();
+			}
 		}
+		top += inlineRow.height;
 	}
 }
 
@@ -955,6 +968,7 @@ void GifsListWidget::onPreview() {
 void GifsListWidget::onUpdateInlineItems() {
 	auto ms = getms();
 	if (_lastScrolled + 100 <= ms) {
+		preloadImages();
 		update();
 	} else {
 		_updateInlineItems.start(_lastScrolled + 100 - ms);
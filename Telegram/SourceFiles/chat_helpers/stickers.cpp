@@ -36,8 +36,62 @@ namespace {
 constexpr int kReadFeaturedSetsTimeoutMs = 1000;
 QPointer<internal::FeaturedReader> FeaturedReaderInstance;
 
+struct ListsByEmoji {
+	bool valid = false;
+	Order order; // Shares data with the indexed order while it is not changed.
+	StickersByEmojiMap lists;
+};
+
+ListsByEmoji &ListsByEmojiInstance() {
+	static ListsByEmoji result;
+	return result;
+}
+
+void RebuildListsByEmoji(ListsByEmoji &index) {
+	index.valid = true;
+	index.order = Global::StickerSetsOrder();
+	index.lists.clear();
+
+	auto setsToRequest = QMap<uint64, uint64>();
+	auto &sets = Global::RefStickerSets();
+	for_const (auto setId, index.order) {
+		auto it = sets.find(setId);
+		if (it == sets.cend()) {
+			continue;
+		} else if (it->emoji.isEmpty()) {
+			setsToRequest.insert(it->id, it->access);
+			it->flags |= MTPDstickerSet_ClientFlag::f_not_loaded;
+		} else if (!(it->flags & MTPDstickerSet::Flag::f_archived)) {
+			for (auto i = it->emoji.cbegin(), e = it->emoji.cend(); i != e; ++i) {
+				index.lists[i.key()] += i.value();
+			}
+		}
+	}
+	if (!setsToRequest.isEmpty() && App::api()) {
+		for (auto i = setsToRequest.cbegin(), e = setsToRequest.cend(); i != e; ++i) {
+			App::api()->scheduleStickerSetRequest(i.key(), i.value());
+		}
+		App::api()->requestStickerSets();
+	}
+}
+
 } // namespace
 
+StickerPack GetListByEmoji(EmojiPtr emoji) {
+	auto &index = ListsByEmojiInstance();
+	if (!index.valid || index.order != Global::StickerSetsOrder()) {
+		RebuildListsByEmoji(index);
+	}
+	return index.lists.value(emoji->original());
+}
+
+void InvalidateListsByEmoji() {
+	auto &index = ListsByEmojiInstance();
+	index.valid = false;
+	index.order = Order();
+	index.lists.clear();
+}
+
 void applyArchivedResult(const MTPDmessages_stickerSetInstallResultArchive &d) {
 	auto &v = d.vsets.v;
 	auto &order = Global::RefStickerSetsOrder();
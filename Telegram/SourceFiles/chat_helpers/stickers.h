@@ -32,6 +32,11 @@ void installLocally(uint64 setId);
 void undoInstallLocally(uint64 setId);
 void markFeaturedAsRead(uint64 setId);
 
+// Stickers of the installed sets for the emoji, in the sets order.
+// The index is rebuilt lazily after the installed sets are changed.
+StickerPack GetListByEmoji(EmojiPtr emoji);
+void InvalidateListsByEmoji();
+
 namespace internal {
 
 class FeaturedReader : public QObject, private MTP::Sender {
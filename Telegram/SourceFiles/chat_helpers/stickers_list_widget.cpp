@@ -39,6 +39,7 @@ namespace {
 
 constexpr auto kStickersPanelPerRow = Stickers::kPanelPerRow;
 constexpr auto kInlineItemsMaxPerRow = 5;
+constexpr auto kLoadAfterScrollTimeout = TimeMs(100);
 
 } // namespace
 
@@ -441,6 +442,8 @@ StickersListWidget::StickersListWidget(QWidget *parent, gsl::not_null<Window::Co
 	_previewTimer.setSingleShot(true);
 	connect(&_previewTimer, SIGNAL(timeout()), this, SLOT(onPreview()));
 
+	_loadAfterScrollTimer.setCallback([this] { update(); });
+
 	subscribe(AuthSession::CurrentDownloaderTaskFinished(), [this] {
 		update();
 		readVisibleSets();
@@ -457,6 +460,9 @@ object_ptr<TabbedSelector::InnerFooter> StickersListWidget::createFooter() {
 void StickersListWidget::setVisibleTopBottom(int visibleTop, int visibleBottom) {
 	auto top = getVisibleTop();
 	Inner::setVisibleTopBottom(visibleTop, visibleBottom);
+	if (top != getVisibleTop()) {
+		_lastScrolled = getms();
+	}
 	if (_section == Section::Featured) {
 		readVisibleSets();
 	}
@@ -771,8 +777,12 @@ void StickersListWidget::paintSticker(Painter &p, Set &set, int y, int index, bo
 		App::roundRect(p, QRect(tl, st::stickerPanSize), st::emojiPanHover, StickerHoverCorners);
 	}
 
+	// Don't start loading and decoding the stickers that are
+	// scrolled past quickly, repaint when the scrolling stops.
 	auto goodThumb = !sticker->thumb->isNull() && ((sticker->thumb->width() >= 128) || (sticker->thumb->height() >= 128));
-	if (goodThumb) {
+	if (_lastScrolled + kLoadAfterScrollTimeout > getms()) {
+		_loadAfterScrollTimer.callOnce(kLoadAfterScrollTimeout);
+	} else if (goodThumb) {
 		sticker->thumb->load();
 	} else {
 		sticker->checkSticker();
@@ -22,6 +22,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 #include "chat_helpers/tabbed_selector.h"
 #include "base/variant.h"
+#include "base/timer.h"
 
 namespace Window {
 class Controller;
@@ -211,6 +212,9 @@ private:
 	QTimer _previewTimer;
 	bool _previewShown = false;
 
+	TimeMs _lastScrolled = 0;
+	base::Timer _loadAfterScrollTimer;
+
 };
 
 } // namespace ChatHelpers
@@ -0,0 +1,89 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "data/data_online_text_changes.h"
+
+namespace Data {
+
+OnlineTextChanges::OnlineTextChanges() : _timer([this] { timerCallback(); }) {
+}
+
+void OnlineTextChanges::track(gsl::not_null<UserData*> user) {
+	auto now = unixtime();
+	track(user, now + App::onlineWillChangeIn(user, now));
+}
+
+void OnlineTextChanges::track(gsl::not_null<UserData*> user, TimeId changesAt) {
+	auto i = _scheduledAt.find(user);
+	if (i != _scheduledAt.cend()) {
+		if (i->second <= changesAt) {
+			return; // The user is notified earlier anyway.
+		}
+		auto j = _schedule.find(i->second);
+		if (j != _schedule.cend()) {
+			auto &users = j->second;
+			users.erase(std::remove(users.begin(), users.end(), user.get()), users.end());
+			if (users.empty()) {
+				_schedule.erase(j);
+			}
+		}
+		i->second = changesAt;
+	} else {
+		_scheduledAt.emplace(user, changesAt);
+	}
+	_schedule[changesAt].push_back(user);
+	if (!_timerFiresAt || changesAt < _timerFiresAt) {
+		restartTimer(unixtime());
+	}
+}
+
+void OnlineTextChanges::timerCallback() {
+	_timerFiresAt = 0;
+
+	auto now = unixtime();
+	auto changed = std::vector<UserData*>();
+	while (!_schedule.empty() && _schedule.begin()->first <= now) {
+		for (auto user : _schedule.begin()->second) {
+			_scheduledAt.erase(user);
+			changed.push_back(user);
+		}
+		_schedule.erase(_schedule.begin());
+	}
+	if (!changed.empty()) {
+		// The handlers track the users again with the new change times.
+		_changed.notify(std::move(changed), true);
+	}
+	if (!_timerFiresAt) {
+		restartTimer(unixtime());
+	}
+}
+
+void OnlineTextChanges::restartTimer(TimeId now) {
+	if (_schedule.empty()) {
+		_timerFiresAt = 0;
+		_timer.cancel();
+		return;
+	}
+	_timerFiresAt = _schedule.begin()->first;
+	auto timeout = qMax(_timerFiresAt - now, 0) * 1000LL + 1;
+	_timer.callOnce(timeout);
+}
+
+} // namespace Data
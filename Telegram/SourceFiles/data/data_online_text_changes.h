@@ -0,0 +1,57 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include "base/timer.h"
+
+namespace Data {
+
+// One timer for all the online status texts shown in the app.
+// Widgets ask to track the users whose status they show and get all
+// the users with outdated status texts in a single notification.
+class OnlineTextChanges {
+public:
+	OnlineTextChanges();
+
+	// Changes at the time App::onlineWillChangeIn() reports for the user.
+	void track(gsl::not_null<UserData*> user);
+	void track(gsl::not_null<UserData*> user, TimeId changesAt);
+
+	base::Observable<std::vector<UserData*>> &changed() {
+		return _changed;
+	}
+
+private:
+	void timerCallback();
+	void restartTimer(TimeId now);
+
+	base::Timer _timer;
+	TimeId _timerFiresAt = 0;
+
+	// Users grouped by the second when their status text changes.
+	std::map<TimeId, std::vector<UserData*>> _schedule;
+	std::map<UserData*, TimeId> _scheduledAt;
+
+	base::Observable<std::vector<UserData*>> _changed;
+
+};
+
+} // namespace Data
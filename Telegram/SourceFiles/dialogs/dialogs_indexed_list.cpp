@@ -28,6 +28,7 @@ IndexedList::IndexedList(SortMode sortMode)
 }
 
 RowsByLetter IndexedList::addToEnd(History *history) {
+	++_changesCount;
 	RowsByLetter result;
 	if (!_list.contains(history->peer->id)) {
 		result.insert(0, _list.addToEnd(history));
@@ -43,6 +44,7 @@ RowsByLetter IndexedList::addToEnd(History *history) {
 }
 
 Row *IndexedList::addByName(History *history) {
+	++_changesCount;
 	if (auto row = _list.getRow(history->peer->id)) {
 		return row;
 	}
@@ -59,6 +61,7 @@ Row *IndexedList::addByName(History *history) {
 }
 
 void IndexedList::adjustByPos(const RowsByLetter &links) {
+	++_changesCount;
 	for (auto i = links.cbegin(), e = links.cend(); i != e; ++i) {
 		if (i.key() == QChar(0)) {
 			_list.adjustByPos(i.value());
@@ -71,6 +74,7 @@ void IndexedList::adjustByPos(const RowsByLetter &links) {
 }
 
 void IndexedList::moveToTop(PeerData *peer) {
+	++_changesCount;
 	if (_list.moveToTop(peer->id)) {
 		for_const (auto ch, peer->chars) {
 			if (auto list = _index.value(ch)) {
@@ -81,6 +85,7 @@ void IndexedList::moveToTop(PeerData *peer) {
 }
 
 void IndexedList::movePinned(Row *row, int deltaSign) {
+	++_changesCount;
 	auto swapPinnedIndexWith = find(row);
 	t_assert(swapPinnedIndexWith != cend());
 	if (deltaSign > 0) {
@@ -100,6 +105,7 @@ void IndexedList::movePinned(Row *row, int deltaSign) {
 }
 
 void IndexedList::peerNameChanged(PeerData *peer, const PeerData::Names &oldNames, const PeerData::NameFirstChars &oldChars) {
+	++_changesCount;
 	t_assert(_sortMode != SortMode::Date);
 	if (_sortMode == SortMode::Name) {
 		adjustByName(peer, oldNames, oldChars);
@@ -109,6 +115,7 @@ void IndexedList::peerNameChanged(PeerData *peer, const PeerData::Names &oldName
 }
 
 void IndexedList::peerNameChanged(Mode list, PeerData *peer, const PeerData::Names &oldNames, const PeerData::NameFirstChars &oldChars) {
+	++_changesCount;
 	t_assert(_sortMode == SortMode::Date);
 	adjustNames(list, peer, oldNames, oldChars);
 }
@@ -183,6 +190,7 @@ void IndexedList::adjustNames(Mode list, PeerData *peer, const PeerData::Names &
 }
 
 void IndexedList::del(const PeerData *peer, Row *replacedBy) {
+	++_changesCount;
 	if (_list.del(peer->id, replacedBy)) {
 		for_const (auto ch, peer->chars) {
 			if (auto list = _index.value(ch)) {
@@ -193,6 +201,7 @@ void IndexedList::del(const PeerData *peer, Row *replacedBy) {
 }
 
 void IndexedList::clear() {
+	++_changesCount;
 	for_const (auto &list, _index) {
 		delete list;
 	}
@@ -51,6 +51,10 @@ public:
 	const List &all() const {
 		return _list;
 	}
+	// Changes each time the rows, their order or their names change.
+	int changesCount() const {
+		return _changesCount;
+	}
 	const List *filtered(QChar ch) const {
 		static StaticNeverFreedPointer<List> empty(new List(SortMode::Add));
 		return _index.value(ch, empty.data());
@@ -88,6 +92,7 @@ private:
 	List _list;
 	using Index = QMap<QChar, List*>;
 	Index _index;
+	int _changesCount = 0;
 
 };
 
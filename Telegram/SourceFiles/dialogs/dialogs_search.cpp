@@ -0,0 +1,111 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "dialogs/dialogs_search.h"
+
+#include "dialogs/dialogs_indexed_list.h"
+
+namespace Dialogs {
+
+QStringList SearchWords(const QString &query) {
+	auto result = QStringList();
+	if (query.isEmpty()) {
+		return result;
+	}
+	auto words = query.split(cWordSplit(), QString::SkipEmptyParts);
+	result.reserve(words.size());
+	for_const (auto &word, words) {
+		auto trimmed = word.trimmed();
+		if (!trimmed.isEmpty()) {
+			result.push_back(trimmed);
+		}
+	}
+	return result;
+}
+
+bool PeerMatchesSearchWords(gsl::not_null<PeerData*> peer, const QStringList &words) {
+	auto &names = peer->names;
+	for_const (auto &word, words) {
+		auto found = false;
+		for_const (auto &name, names) {
+			if (name.startsWith(word)) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void AppendSearchResults(QVector<Row*> &results, const IndexedList &list, const QStringList &words) {
+	if (list.isEmpty() || words.isEmpty()) {
+		return;
+	}
+
+	// Check only the smallest of the lists indexed by the words first letters.
+	auto toFilter = (const List*)nullptr;
+	for_const (auto &word, words) {
+		auto found = list.filtered(word[0]);
+		if (found->isEmpty()) {
+			return;
+		} else if (!toFilter || toFilter->size() > found->size()) {
+			toFilter = found;
+		}
+	}
+	results.reserve(results.size() + toFilter->size());
+	for_const (auto row, *toFilter) {
+		if (PeerMatchesSearchWords(row->history()->peer, words)) {
+			results.push_back(row);
+		}
+	}
+}
+
+bool SearchState::canNarrow(const QStringList &words, int listChanges) const {
+	if (_words.isEmpty() || words.isEmpty() || _listChanges != listChanges) {
+		return false;
+	}
+	for_const (auto &previous, _words) {
+		auto extended = false;
+		for_const (auto &word, words) {
+			if (word.startsWith(previous)) {
+				extended = true;
+				break;
+			}
+		}
+		if (!extended) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void SearchState::remember(const QStringList &words, int listChanges) {
+	_words = words;
+	_listChanges = listChanges;
+}
+
+void SearchState::invalidate() {
+	_words.clear();
+}
+
+} // namespace Dialogs
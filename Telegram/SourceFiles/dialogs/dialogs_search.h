@@ -0,0 +1,63 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace Dialogs {
+
+class Row;
+class IndexedList;
+
+// Splits the query (already passed through textSearchKey()) to words.
+QStringList SearchWords(const QString &query);
+
+// Every search word must be a prefix of one of the peer name parts.
+bool PeerMatchesSearchWords(gsl::not_null<PeerData*> peer, const QStringList &words);
+
+// Appends all the rows of the list that match all the search words.
+void AppendSearchResults(QVector<Row*> &results, const IndexedList &list, const QStringList &words);
+
+// Leaves only the rows that match all the search words, keeping the order.
+template <typename Rows, typename PeerGetter>
+void NarrowSearchResults(Rows &rows, const QStringList &words, PeerGetter &&getPeer) {
+	auto end = std::remove_if(rows.begin(), rows.end(), [&words, &getPeer](auto row) {
+		return !PeerMatchesSearchWords(getPeer(row), words);
+	});
+	rows.erase(end, rows.end());
+}
+
+// Remembers the words the current search results were found by.
+// When the query is only extended (each old word is a prefix of some
+// new word) every new result is among the old ones, so the results
+// can be narrowed instead of searching the whole list once again.
+class SearchState {
+public:
+	// The listChanges value must change each time the searched list does.
+	bool canNarrow(const QStringList &words, int listChanges) const;
+	void remember(const QStringList &words, int listChanges);
+	void invalidate();
+
+private:
+	QStringList _words;
+	int _listChanges = 0;
+
+};
+
+} // namespace Dialogs
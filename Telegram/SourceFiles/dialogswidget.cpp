@@ -146,6 +146,7 @@ void DialogsInner::paintRegion(Painter &p, const QRegion &region, bool paintingO
 
 	if (!App::main()) return;
 
+	auto paintFrame = _paintTimings.measure(getFullWidth());
 	auto r = region.boundingRect();
 	if (!paintingOther) {
 		p.setClipRect(r);
@@ -1237,103 +1238,37 @@ void DialogsInner::onPeerPhotoChanged(PeerData *peer) {
 void DialogsInner::onFilterUpdate(QString newFilter, bool force) {
 	newFilter = textSearchKey(newFilter);
 	if (newFilter != _filter || force) {
-		QStringList f;
-		if (!newFilter.isEmpty()) {
-			QStringList filterList = newFilter.split(cWordSplit(), QString::SkipEmptyParts);
-			int l = filterList.size();
-
-			f.reserve(l);
-			for (int i = 0; i < l; ++i) {
-				QString filterName = filterList[i].trimmed();
-				if (filterName.isEmpty()) continue;
-				f.push_back(filterName);
-			}
-			newFilter = f.join(' ');
-		}
+		auto words = Dialogs::SearchWords(newFilter);
+		newFilter = words.join(' ');
 		if (newFilter != _filter || force) {
 			_filter = newFilter;
 			if (!_searchInPeer && _filter.isEmpty()) {
 				_state = DefaultState;
 				_hashtagResults.clear();
 				_filterResults.clear();
+				_filterSearchState.invalidate();
 				_peerSearchResults.clear();
 				_searchResults.clear();
 				_lastSearchDate = 0;
 				_lastSearchPeer = 0;
 				_lastSearchId = _lastSearchMigratedId = 0;
 			} else {
-				QStringList::const_iterator fb = f.cbegin(), fe = f.cend(), fi;
-
 				_state = FilteredState;
-				_filterResults.clear();
-				if (!_searchInPeer && !f.isEmpty()) {
-					const Dialogs::List *toFilter = nullptr;
-					if (!_dialogs->isEmpty()) {
-						for (fi = fb; fi != fe; ++fi) {
-							auto found = _dialogs->filtered(fi->at(0));
-							if (found->isEmpty()) {
-								toFilter = nullptr;
-								break;
-							}
-							if (!toFilter || toFilter->size() > found->size()) {
-								toFilter = found;
-							}
-						}
-					}
-					const Dialogs::List *toFilterContacts = nullptr;
-					if (!_contactsNoDialogs->isEmpty()) {
-						for (fi = fb; fi != fe; ++fi) {
-							auto found = _contactsNoDialogs->filtered(fi->at(0));
-							if (found->isEmpty()) {
-								toFilterContacts = nullptr;
-								break;
-							}
-							if (!toFilterContacts || toFilterContacts->size() > found->size()) {
-								toFilterContacts = found;
-							}
-						}
-					}
-					_filterResults.reserve((toFilter ? toFilter->size() : 0) + (toFilterContacts ? toFilterContacts->size() : 0));
-					if (toFilter) {
-						for_const (auto row, *toFilter) {
-							const PeerData::Names &names(row->history()->peer->names);
-							PeerData::Names::const_iterator nb = names.cbegin(), ne = names.cend(), ni;
-							for (fi = fb; fi != fe; ++fi) {
-								QString filterName(*fi);
-								for (ni = nb; ni != ne; ++ni) {
-									if (ni->startsWith(*fi)) {
-										break;
-									}
-								}
-								if (ni == ne) {
-									break;
-								}
-							}
-							if (fi == fe) {
-								_filterResults.push_back(row);
-							}
-						}
-					}
-					if (toFilterContacts) {
-						for_const (auto row, *toFilterContacts) {
-							const PeerData::Names &names(row->history()->peer->names);
-							PeerData::Names::const_iterator nb = names.cbegin(), ne = names.cend(), ni;
-							for (fi = fb; fi != fe; ++fi) {
-								QString filterName(*fi);
-								for (ni = nb; ni != ne; ++ni) {
-									if (ni->startsWith(*fi)) {
-										break;
-									}
-								}
-								if (ni == ne) {
-									break;
-								}
-							}
-							if (fi == fe) {
-								_filterResults.push_back(row);
-							}
-						}
+				if (!_searchInPeer && !words.isEmpty()) {
+					auto listChanges = _dialogs->changesCount() + _contactsNoDialogs->changesCount();
+					if (!force && _filterSearchState.canNarrow(words, listChanges)) {
+						Dialogs::NarrowSearchResults(_filterResults, words, [](Dialogs::Row *row) {
+							return row->history()->peer;
+						});
+					} else {
+						_filterResults.clear();
+						Dialogs::AppendSearchResults(_filterResults, *_dialogs, words);
+						Dialogs::AppendSearchResults(_filterResults, *_contactsNoDialogs, words);
 					}
+					_filterSearchState.remember(words, listChanges);
+				} else {
+					_filterResults.clear();
+					_filterSearchState.invalidate();
 				}
 			}
 		}
@@ -1699,6 +1634,7 @@ void DialogsInner::setState(State newState) {
 		_hashtagResults.clear();
 		_hashtagSelected = -1;
 		_filterResults.clear();
+		_filterSearchState.invalidate();
 		_filteredSelected = -1;
 	}
 	onFilterUpdate(_filter, true);
@@ -1733,6 +1669,7 @@ void DialogsInner::clearFilter() {
 		}
 		_hashtagResults.clear();
 		_filterResults.clear();
+		_filterSearchState.invalidate();
 		_peerSearchResults.clear();
 		_searchResults.clear();
 		_lastSearchDate = 0;
@@ -2043,6 +1980,7 @@ void DialogsInner::destroyData() {
 	_hashtagResults.clear();
 	_filteredSelected = -1;
 	_filterResults.clear();
+	_filterSearchState.invalidate();
 	_filter.clear();
 	_searchedSelected = _peerSearchSelected = -1;
 	clearSearchResults();
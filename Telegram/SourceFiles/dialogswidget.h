@@ -22,6 +22,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 #include "window/section_widget.h"
 #include "ui/widgets/scroll_area.h"
+#include "dialogs/dialogs_search.h"
+#include "ui/paint_timings.h"
 
 namespace Dialogs {
 class Row;
@@ -269,6 +271,7 @@ private:
 	bool _hashtagDeletePressed = false;
 
 	FilteredDialogs _filterResults;
+	Dialogs::SearchState _filterSearchState;
 	int _filteredSelected = -1;
 	int _filteredPressed = -1;
 
@@ -301,6 +304,8 @@ private:
 
 	base::lambda<void()> _loadMoreCallback;
 
+	Ui::PaintTimings _paintTimings { qsl("DialogsInner") };
+
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(DialogsInner::UpdateRowSections);
@@ -33,6 +33,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "observer_peer.h"
 #include "auth_session.h"
 #include "window/notifications_manager.h"
+#include "media/player/media_player_instance.h"
+#include "base/slab_allocator.h"
 
 namespace {
 
@@ -50,6 +52,9 @@ constexpr auto kStatusShowClientsideChooseContact = 6000;
 constexpr auto kStatusShowClientsidePlayGame = 10000;
 constexpr auto kSetMyActionForMs = 10000;
 constexpr auto kNewBlockEachMessage = 50;
+constexpr auto kUnloadInactiveTimeout = TimeMs(30 * 60 * 1000);
+constexpr auto kUnloadKeepAroundCount = 100;
+constexpr auto kUnloadMinItemsCount = 4 * kUnloadKeepAroundCount;
 
 auto GlobalPinnedIndex = 0;
 
@@ -607,6 +612,50 @@ void Histories::clear() {
 	typing.clear();
 }
 
+void Histories::unloadInactive(TimeMs now) {
+	// Keep the shown histories, the ones the playlists are built from
+	// and the ones that have messages selected for forwarding.
+	auto main = App::main();
+	auto kept = QVector<PeerData*>();
+	if (main) {
+		kept.push_back(main->historyPeer());
+		kept.push_back(main->overviewPeer());
+	}
+	for (auto type : { AudioMsgId::Type::Song, AudioMsgId::Type::Voice }) {
+		if (auto item = App::histItemById(Media::Player::instance()->current(type).contextId())) {
+			kept.push_back(item->history()->peer);
+		}
+	}
+	auto isKept = [main, &kept](History *history) {
+		auto peer = history->peer;
+		for_const (auto keptPeer, kept) {
+			if (!keptPeer) {
+				continue;
+			} else if (peer == keptPeer || peer->migrateTo() == keptPeer || keptPeer->migrateTo() == peer) {
+				return true;
+			}
+		}
+		return main && main->hasForwardingItemsFrom(history);
+	};
+	auto unloaded = 0;
+	for_const (auto history, map) {
+		if (history->lastShownAt() + kUnloadInactiveTimeout > now) {
+			continue;
+		} else if (history->loadedItemsCount() < kUnloadMinItemsCount) {
+			continue;
+		} else if (isKept(history)) {
+			continue;
+		}
+		if (history->unloadBlocks()) {
+			++unloaded;
+		}
+	}
+	if (unloaded) {
+		auto released = base::SlabTrim();
+		DEBUG_LOG(("Histories: unloaded %1 inactive histories, released %2 bytes.").arg(unloaded).arg(int64(released)));
+	}
+}
+
 void Histories::regSendAction(History *history, UserData *user, const MTPSendMessageAction &action, TimeId when) {
 	if (history->updateSendActionNeedsAnimating(user, action)) {
 		user->madeAction(when);
@@ -1891,7 +1940,9 @@ void History::updateChatListSortPosition() {
 
 	_sortKeyInChatList = isPinnedDialog() ? pinnedDialogPos(_pinnedIndex) : dialogPosFromDate(chatListDate());
 	if (auto m = App::main()) {
-		if (needUpdateInChatList()) {
+		if (m->deferChatListUpdate(peer, true)) {
+			return;
+		} else if (needUpdateInChatList()) {
 			if (_sortKeyInChatList) {
 				m->createDialog(this);
 				updateChatListEntry();
@@ -1991,20 +2042,7 @@ void History::clear(bool leaveItems) {
 			}
 		}
 	}
-	for (int32 i = 0; i < OverviewCount; ++i) {
-		if (!overview[i].isEmpty() || !overviewIds[i].isEmpty()) {
-			if (leaveItems) {
-				if (overviewCountData[i] == 0) {
-					overviewCountData[i] = overview[i].size();
-				}
-			} else {
-				overviewCountData[i] = -1; // not loaded yet
-			}
-			overview[i].clear();
-			overviewIds[i].clear();
-			if (!App::quitting()) Notify::mediaOverviewUpdated(peer, MediaOverviewType(i));
-		}
-	}
+	clearOverviews(leaveItems);
 	clearBlocks(leaveItems);
 	if (leaveItems) {
 		lastKeyboardInited = false;
@@ -2032,6 +2070,99 @@ void History::clear(bool leaveItems) {
 	if (leaveItems && App::main()) App::main()->historyCleared(this);
 }
 
+void History::clearOverviews(bool leaveItems) {
+	for (int32 i = 0; i < OverviewCount; ++i) {
+		if (!overview[i].isEmpty() || !overviewIds[i].isEmpty()) {
+			if (leaveItems) {
+				if (overviewCountData[i] == 0) {
+					overviewCountData[i] = overview[i].size();
+				}
+			} else {
+				overviewCountData[i] = -1; // not loaded yet
+			}
+			overview[i].clear();
+			overviewIds[i].clear();
+			if (!App::quitting()) Notify::mediaOverviewUpdated(peer, MediaOverviewType(i));
+		}
+	}
+}
+
+bool History::unloadBlocks() {
+	auto items = std::vector<HistoryItem*>();
+	items.reserve(loadedItemsCount());
+	for_const (auto block, blocks) {
+		for_const (auto item, block->items) {
+			items.push_back(item);
+		}
+	}
+
+	// Keep the items around the saved scroll position, so that the history
+	// is shown at once when it is opened again. Without a scroll position
+	// it is shown at the bottom or, for the old group, at the joined top.
+	auto count = int(items.size());
+	auto center = count - 1;
+	auto migrated = peer->migrateFrom() ? App::historyLoaded(peer->migrateFrom()->id) : nullptr;
+	if (scrollTopItem && !scrollTopItem->detached()) {
+		center = int(std::find(items.cbegin(), items.cend(), scrollTopItem) - items.cbegin());
+	} else if (migrated && migrated->scrollTopItem) {
+		center = 0;
+	}
+	auto keepFrom = qMax(center - kUnloadKeepAroundCount, 0);
+	auto keepTill = qMin(center + kUnloadKeepAroundCount + 1, count);
+	if (keepFrom == 0 && keepTill == count) {
+		return false;
+	}
+
+	auto unloaded = std::vector<HistoryItem*>();
+	unloaded.reserve(count - (keepTill - keepFrom));
+	for (auto i = count; i != keepTill;) {
+		unloaded.push_back(items[--i]);
+	}
+	for (auto i = keepFrom; i != 0;) {
+		unloaded.push_back(items[--i]);
+	}
+	for (auto item : unloaded) {
+		item->detach();
+	}
+	if (keepFrom > 0) {
+		oldLoaded = false;
+	}
+	if (keepTill < count) {
+		newLoaded = false;
+	}
+	clearOverviews(true);
+
+	// Items referenced from elsewhere stay alive in a detached state,
+	// all the other detached items can be deleted directly.
+	auto &pending = Global::RefPendingRepaintItems();
+	for (auto item : unloaded) {
+		if (!keepItemWhenUnloading(item)) {
+			pending.remove(item);
+			delete item;
+		}
+	}
+	return true;
+}
+
+bool History::keepItemWhenUnloading(HistoryItem *item) const {
+	if (item == lastMsg || item->id <= 0 || item->id == lastKeyboardId) {
+		return true;
+	} else if (isMegagroup() && peer->asChannel()->mgInfo->pinnedMsgId == item->id) {
+		return true;
+	} else if (notifies.contains(item)) {
+		return true;
+	}
+	return App::historyHasDependent(item);
+}
+
+int History::loadedItemsCount() const {
+	auto result = 0;
+	for_const (auto block, blocks) {
+		result += block->items.size();
+	}
+	return result;
+}
+
 void History::clearBlocks(bool leaveItems) {
 	Blocks lst;
 	std::swap(lst, blocks);
@@ -2100,7 +2231,9 @@ void History::addChatListEntryByLetter(Dialogs::Mode list, QChar letter, Dialogs
 
 void History::updateChatListEntry() const {
 	if (auto main = App::main()) {
-		if (inChatList(Dialogs::Mode::All)) {
+		if (main->deferChatListUpdate(peer, false)) {
+			return;
+		} else if (inChatList(Dialogs::Mode::All)) {
 			main->dlgUpdated(Dialogs::Mode::All, mainChatListLink(Dialogs::Mode::All));
 			if (inChatList(Dialogs::Mode::Important)) {
 				main->dlgUpdated(Dialogs::Mode::Important, mainChatListLink(Dialogs::Mode::Important));
@@ -55,6 +55,9 @@ public:
 	void clear();
 	void remove(const PeerId &peer);
 
+	// Unloads items of the histories that were not shown for a while.
+	void unloadInactive(TimeMs now);
+
 	HistoryItem *addNewMessage(const MTPMessage &msg, NewMessageType type);
 
 	typedef QMap<History*, TimeMs> TypingHistories; // when typing in this history started
@@ -207,6 +210,20 @@ public:
 
 	void clear(bool leaveItems = false);
 
+	// Deletes loaded items far from the saved scroll position to free
+	// memory, they are requested again when scrolled to. Items referenced
+	// from elsewhere (the last message, replies, notifications) stay alive
+	// in a detached state. Returns false if there was nothing to unload.
+	bool unloadBlocks();
+	int loadedItemsCount() const;
+
+	TimeMs lastShownAt() const {
+		return _lastShownAt;
+	}
+	void setLastShownAt(TimeMs ms) {
+		_lastShownAt = ms;
+	}
+
 	virtual ~History();
 
 	HistoryItem *addNewService(MsgId msgId, QDateTime date, const QString &text, MTPDmessage::Flags flags = 0, bool newMsg = true);
@@ -473,6 +490,7 @@ protected:
 	void removeBlock(HistoryBlock *block);
 
 	void clearBlocks(bool leaveItems);
+	void clearOverviews(bool leaveItems);
 
 	HistoryItem *createItem(const MTPMessage &msg, bool applyServiceAction, bool detachExistingItem);
 	HistoryItem *createItemForwarded(MsgId id, MTPDmessage::Flags flags, QDateTime date, int32 from, HistoryMessage *msg);
@@ -507,6 +525,8 @@ private:
 	// Add all items to the media overview if we were not loaded at bottom and now are.
 	void checkAddAllToOverview();
 
+	bool keepItemWhenUnloading(HistoryItem *item) const;
+
 	enum class Flag {
 		f_has_pending_resized_items = (1 << 0),
 		f_pending_resize            = (1 << 1),
@@ -524,6 +544,7 @@ private:
 	Flags _flags;
 	bool _mute;
 	int32 _unreadCount = 0;
+	TimeMs _lastShownAt = 0;
 
 	Dialogs::RowsByLetter _chatListLinks[2];
 	Dialogs::RowsByLetter &chatListLinks(Dialogs::Mode list) {
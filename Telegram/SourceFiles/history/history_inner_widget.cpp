@@ -369,6 +369,7 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 	if (hasPendingResizedItems()) {
 		return;
 	}
+	auto paintFrame = _paintTimings.measure(width());
 
 	Painter p(this);
 	QRect r(e->rect());
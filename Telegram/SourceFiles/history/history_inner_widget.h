@@ -23,6 +23,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "ui/widgets/tooltip.h"
 #include "ui/widgets/scroll_area.h"
 #include "window/top_bar_widget.h"
+#include "ui/paint_timings.h"
 
 namespace Window {
 class Controller;
@@ -263,6 +264,8 @@ private:
 	int _scrollDateLastItemTop = 0;
 	ClickHandlerPtr _scrollDateLink;
 
+	Ui::PaintTimings _paintTimings { qsl("HistoryInner") };
+
 	enum class EnumItemsDirection {
 		TopToBottom,
 		BottomToTop,
@@ -462,6 +462,14 @@ TextSelection shiftSelection(TextSelection selection, const Text &byText);
 
 class HistoryItem : public HistoryElement, public RuntimeComposer, public ClickHandlerHost {
 public:
+	// Items are created in slices of hundreds, take them from the slab pool.
+	static void *operator new(std::size_t size) {
+		return base::SlabAllocate(size);
+	}
+	static void operator delete(void *pointer, std::size_t size) {
+		base::SlabFree(pointer, size);
+	}
+
 	int resizeGetHeight(int width) {
 		if (_flags & MTPDmessage_ClientFlag::f_pending_init_dimensions) {
 			_flags &= ~MTPDmessage_ClientFlag::f_pending_init_dimensions;
@@ -69,6 +69,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "ui/widgets/popup_menu.h"
 #include "platform/platform_file_utilities.h"
 #include "auth_session.h"
+#include "data/data_online_text_changes.h"
 #include "window/notifications_manager.h"
 #include "window/window_controller.h"
 #include "inline_bots/inline_results_widget.h"
@@ -509,6 +510,9 @@ HistoryWidget::HistoryWidget(QWidget *parent, gsl::not_null<Window::Controller*>
 	setAcceptDrops(true);
 
 	subscribe(AuthSession::CurrentDownloaderTaskFinished(), [this] { update(); });
+	subscribe(AuthSession::Current().onlineTextChanges().changed(), [this](const std::vector<UserData*> &users) {
+		onlineTextsChanged(users);
+	});
 	connect(_topBar, &Window::TopBarWidget::clicked, this, [this] { topBarClick(); });
 	connect(_scroll, SIGNAL(scrolled()), this, SLOT(onScroll()));
 	connect(_historyDown, SIGNAL(clicked()), this, SLOT(onHistoryToEnd()));
@@ -1835,6 +1839,10 @@ void HistoryWidget::showHistory(const PeerId &peerId, MsgId showAtMsgId, bool re
 		}
 
 		_history->showAtMsgId = _showAtMsgId;
+		_history->setLastShownAt(getms());
+		if (_migrated) {
+			_migrated->setLastShownAt(getms());
+		}
 
 		destroyUnreadBar();
 		destroyPinnedBar();
@@ -4073,28 +4081,32 @@ void HistoryWidget::updateOnlineDisplay() {
 			_topBar->update();
 		}
 	}
-	updateOnlineDisplayTimer();
+	trackOnlineTextChanges();
 }
 
-void HistoryWidget::updateOnlineDisplayTimer() {
+void HistoryWidget::trackOnlineTextChanges() {
 	if (!_history) return;
 
-	int32 t = unixtime(), minIn = 86400;
-	if (_peer->isUser()) {
-		minIn = App::onlineWillChangeIn(_peer->asUser(), t);
-	} else if (_peer->isChat()) {
-		ChatData *chat = _peer->asChat();
-		if (chat->participants.isEmpty()) return;
+	auto &changes = AuthSession::Current().onlineTextChanges();
+	if (auto user = _peer->asUser()) {
+		changes.track(user);
+	} else if (auto chat = _peer->asChat()) {
+		for (auto i = chat->participants.cbegin(), e = chat->participants.cend(); i != e; ++i) {
+			changes.track(i.key());
+		}
+	}
+}
 
-		for (ChatData::Participants::const_iterator i = chat->participants.cbegin(), e = chat->participants.cend(); i != e; ++i) {
-			int32 onlineWillChangeIn = App::onlineWillChangeIn(i.key(), t);
-			if (onlineWillChangeIn < minIn) {
-				minIn = onlineWillChangeIn;
-			}
+void HistoryWidget::onlineTextsChanged(const std::vector<UserData*> &users) {
+	if (!_history) return;
+
+	auto chat = _peer->asChat();
+	for (auto user : users) {
+		if (user == _peer || (chat && chat->participants.contains(user))) {
+			updateOnlineDisplay();
+			return;
 		}
-	} else if (_peer->isChannel()) {
 	}
-	App::main()->updateOnlineDisplayIn(minIn * 1000);
 }
 
 void HistoryWidget::moveFieldControls() {
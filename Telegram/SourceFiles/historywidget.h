@@ -231,7 +231,8 @@ public:
 	void updateControlsVisibility();
 	void updateControlsGeometry();
 	void updateOnlineDisplay();
-	void updateOnlineDisplayTimer();
+	void trackOnlineTextChanges();
+	void onlineTextsChanged(const std::vector<UserData*> &users);
 
 	void onShareContact(const PeerId &peer, UserData *contact);
 
@@ -43,6 +43,10 @@ namespace internal {
 namespace {
 
 constexpr auto kInlineBotRequestDelay = 400;
+constexpr auto kInlineCacheEntriesLimit = 32;
+constexpr auto kInlineCacheResultsLimit = 1024;
+constexpr auto kInlineCacheTimeMax = 3600; // Seconds.
+constexpr auto kInlinePreloadScreensCount = 2;
 
 } // namespace
 
@@ -376,6 +380,26 @@ void Inner::clearInlineRowsPanel() {
 	clearInlineRows(false);
 }
 
+bool Inner::inlineResultsShown(const Results &results) const {
+	for_const (auto &result, results) {
+		auto it = _inlineLayouts.find(result.get());
+		if (it != _inlineLayouts.cend() && it->second->position() >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void Inner::forgetInlineResults(const Results &results) {
+	if (inlineResultsShown(results)) {
+		// The panel keeps the old rows while hiding for an empty query.
+		clearInlineRowsPanel();
+	}
+	for_const (auto &result, results) {
+		_inlineLayouts.erase(result.get());
+	}
+}
+
 void Inner::refreshSwitchPmButton(const CacheEntry *entry) {
 	if (!entry || entry->switchPmText.isEmpty()) {
 		_switchPmButton.destroy();
@@ -905,7 +929,7 @@ void Widget::showStarted() {
 
 void Widget::onScroll() {
 	auto st = _scroll->scrollTop();
-	if (st + _scroll->height() > _scroll->scrollTopMax()) {
+	if (st + _scroll->height() * internal::kInlinePreloadScreensCount > _scroll->scrollTopMax()) {
 		onInlineRequest();
 	}
 	_inner->setVisibleTopBottom(st, st + _scroll->height());
@@ -950,6 +974,7 @@ void Widget::inlineBotChanged() {
 	if (_inlineRequestId) MTP::cancel(_inlineRequestId);
 	_inlineRequestId = 0;
 	_inlineQuery = _inlineNextQuery = _inlineNextOffset = QString();
+	_inlineNextQueryExpired = false;
 	_inlineBot = nullptr;
 	_inlineCache.clear();
 	_inner->inlineBotChanged();
@@ -958,11 +983,19 @@ void Widget::inlineBotChanged() {
 	Notify::inlineBotRequesting(false);
 }
 
-void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
+void Widget::inlineResultsDone(const MTPmessages_BotResults &result, bool refresh) {
 	_inlineRequestId = 0;
 	Notify::inlineBotRequesting(false);
 
+	// The expired entry results can be shown right now, so they are
+	// destroyed only after the panel is refreshed with the new ones.
+	auto expired = std::unique_ptr<internal::CacheEntry>();
 	auto it = _inlineCache.find(_inlineQuery);
+	if (refresh && it != _inlineCache.cend()) {
+		expired = std::move(it->second);
+		_inlineCache.erase(it);
+		it = _inlineCache.end();
+	}
 	auto adding = (it != _inlineCache.cend());
 	if (result.type() == mtpc_messages_botResults) {
 		auto &d = result.c_messages_botResults();
@@ -971,8 +1004,11 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 
 		if (it == _inlineCache.cend()) {
 			it = _inlineCache.emplace(_inlineQuery, std::make_unique<internal::CacheEntry>()).first;
+			auto cacheTime = snap(d.vcache_time.v, 0, internal::kInlineCacheTimeMax);
+			it->second->expires = getms() + cacheTime * 1000LL;
 		}
 		auto entry = it->second.get();
+		entry->lastUsed = getms();
 		entry->nextOffset = qs(d.vnext_offset);
 		if (d.has_switch_pm() && d.vswitch_pm.type() == mtpc_inlineBotSwitchPM) {
 			auto &switchPm = d.vswitch_pm.c_inlineBotSwitchPM();
@@ -998,12 +1034,42 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 		it->second->nextOffset = QString();
 	}
 
-	if (!showInlineRows(!adding)) {
+	if (!showInlineRows(!adding) && it != _inlineCache.cend()) {
 		it->second->nextOffset = QString();
 	}
+	if (expired) {
+		_inner->forgetInlineResults(expired->results);
+	}
+	checkInlineCacheLimits();
 	onScroll();
 }
 
+void Widget::checkInlineCacheLimits() {
+	auto resultsCount = 0;
+	for_const (auto &entry, _inlineCache) {
+		resultsCount += entry.second->results.size();
+	}
+
+	// Evict the least recently used entries, except the ones in the panel.
+	while (int(_inlineCache.size()) > internal::kInlineCacheEntriesLimit
+		|| resultsCount > internal::kInlineCacheResultsLimit) {
+		auto oldest = _inlineCache.end();
+		for (auto i = _inlineCache.begin(), e = _inlineCache.end(); i != e; ++i) {
+			if (i->first == _inlineQuery || _inner->inlineResultsShown(i->second->results)) {
+				continue;
+			} else if (oldest == e || i->second->lastUsed < oldest->second->lastUsed) {
+				oldest = i;
+			}
+		}
+		if (oldest == _inlineCache.end()) {
+			break;
+		}
+		resultsCount -= oldest->second->results.size();
+		_inner->forgetInlineResults(oldest->second->results);
+		_inlineCache.erase(oldest);
+	}
+}
+
 void Widget::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
 	bool force = false;
 	_inlineQueryPeer = peer;
@@ -1025,12 +1091,18 @@ void Widget::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
 			_inlineRequestId = 0;
 			Notify::inlineBotRequesting(false);
 		}
-		if (_inlineCache.find(query) != _inlineCache.cend()) {
+		auto it = _inlineCache.find(query);
+		auto expired = (it != _inlineCache.cend() && it->second->expires <= getms());
+		if (it != _inlineCache.cend() && !expired) {
+			it->second->lastUsed = getms();
 			_inlineRequestTimer.stop();
 			_inlineQuery = _inlineNextQuery = query;
+			_inlineNextQueryExpired = false;
 			showInlineRows(true);
 		} else {
+			// An expired query is requested again from the first page.
 			_inlineNextQuery = query;
+			_inlineNextQueryExpired = expired;
 			_inlineRequestTimer.start(internal::kInlineBotRequestDelay);
 		}
 	}
@@ -1040,15 +1112,22 @@ void Widget::onInlineRequest() {
 	if (_inlineRequestId || !_inlineBot || !_inlineQueryPeer) return;
 	_inlineQuery = _inlineNextQuery;
 
+	// Pages of the shown entry are requested even after it expires.
 	QString nextOffset;
+	auto refresh = false;
 	auto it = _inlineCache.find(_inlineQuery);
 	if (it != _inlineCache.cend()) {
-		nextOffset = it->second->nextOffset;
-		if (nextOffset.isEmpty()) return;
+		if (_inlineNextQueryExpired) {
+			refresh = true;
+		} else {
+			nextOffset = it->second->nextOffset;
+			if (nextOffset.isEmpty()) return;
+		}
 	}
 	Notify::inlineBotRequesting(true);
-	_inlineRequestId = request(MTPmessages_GetInlineBotResults(MTP_flags(0), _inlineBot->inputUser, _inlineQueryPeer->input, MTPInputGeoPoint(), MTP_string(_inlineQuery), MTP_string(nextOffset))).done([this](const MTPmessages_BotResults &result, mtpRequestId requestId) {
-		inlineResultsDone(result);
+	_inlineRequestId = request(MTPmessages_GetInlineBotResults(MTP_flags(0), _inlineBot->inputUser, _inlineQueryPeer->input, MTPInputGeoPoint(), MTP_string(_inlineQuery), MTP_string(nextOffset))).done([this, refresh](const MTPmessages_BotResults &result, mtpRequestId requestId) {
+		_inlineNextQueryExpired = false;
+		inlineResultsDone(result, refresh);
 	}).fail([this](const RPCError &error) {
 		// show error?
 		Notify::inlineBotRequesting(false);
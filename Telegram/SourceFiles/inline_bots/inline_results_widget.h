@@ -56,6 +56,8 @@ struct CacheEntry {
 	QString nextOffset;
 	QString switchPmText, switchPmStartToken;
 	Results results;
+	TimeMs expires = 0; // The bot's cache_time passed.
+	TimeMs lastUsed = 0;
 };
 
 class Inner : public TWidget, public Context, private base::Subscriber {
@@ -73,6 +75,11 @@ public:
 	void hideInlineRowsPanel();
 	void clearInlineRowsPanel();
 
+	bool inlineResultsShown(const Results &results) const;
+
+	// Clears the panel rows first if some of the results are shown there.
+	void forgetInlineResults(const Results &results);
+
 	void setVisibleTopBottom(int visibleTop, int visibleBottom) override;
 	void preloadImages();
 
@@ -232,7 +239,8 @@ private:
 	int showInlineRows(bool newResults);
 	void recountContentMaxHeight();
 	bool refreshInlineRows(int *added = nullptr);
-	void inlineResultsDone(const MTPmessages_BotResults &result);
+	void inlineResultsDone(const MTPmessages_BotResults &result, bool refresh);
+	void checkInlineCacheLimits();
 
 	gsl::not_null<Window::Controller*> _controller;
 
@@ -261,6 +269,7 @@ private:
 	UserData *_inlineBot = nullptr;
 	PeerData *_inlineQueryPeer = nullptr;
 	QString _inlineQuery, _inlineNextQuery, _inlineNextOffset;
+	bool _inlineNextQueryExpired = false;
 	mtpRequestId _inlineRequestId = 0;
 
 };
@@ -75,6 +75,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 namespace {
 
 constexpr auto kSaveFloatPlayerPositionTimeoutMs = TimeMs(1000);
+constexpr auto kChannelDifferenceRequestsLimit = 8;
+constexpr auto kUnloadHistoriesCheckTimeout = TimeMs(5 * 60 * 1000);
 
 MTPMessagesFilter typeToMediaFilter(MediaOverviewType &type) {
 	switch (type) {
@@ -133,11 +135,12 @@ MainWidget::MainWidget(QWidget *parent, gsl::not_null<Window::Controller*> contr
 	connect(this, SIGNAL(peerPhotoChanged(PeerData*)), this, SIGNAL(dialogsUpdated()));
 	connect(&noUpdatesTimer, SIGNAL(timeout()), this, SLOT(mtpPing()));
 	connect(&_onlineTimer, SIGNAL(timeout()), this, SLOT(updateOnline()));
-	connect(&_onlineUpdater, SIGNAL(timeout()), this, SLOT(updateOnlineDisplay()));
 	connect(&_idleFinishTimer, SIGNAL(timeout()), this, SLOT(checkIdleFinish()));
 	connect(&_bySeqTimer, SIGNAL(timeout()), this, SLOT(getDifference()));
 	connect(&_byPtsTimer, SIGNAL(timeout()), this, SLOT(onGetDifferenceTimeByPts()));
 	connect(&_byMinChannelTimer, SIGNAL(timeout()), this, SLOT(getDifference()));
+	_unloadHistoriesTimer.setCallback([] { App::histories().unloadInactive(getms()); });
+	_unloadHistoriesTimer.callEach(kUnloadHistoriesCheckTimeout);
 	connect(&_failDifferenceTimer, SIGNAL(timeout()), this, SLOT(onGetDifferenceTimeAfterFail()));
 	connect(this, SIGNAL(peerUpdated(PeerData*)), _history, SLOT(peerUpdated(PeerData*)));
 	connect(_history, SIGNAL(historyShown(History*,MsgId)), this, SLOT(onHistoryShown(History*,MsgId)));
@@ -583,6 +586,15 @@ bool MainWidget::hasForwardingItems() {
 	return !_toForward.isEmpty();
 }
 
+bool MainWidget::hasForwardingItemsFrom(gsl::not_null<History*> history) const {
+	for_const (auto item, _toForward) {
+		if (item->history() == history.get()) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void MainWidget::fillForwardingInfo(Text *&from, Text *&text, bool &serviceColor, ImagePtr &preview) {
 	if (_toForward.isEmpty()) return;
 	int32 version = 0;
@@ -1618,6 +1630,10 @@ void MainWidget::readServerHistory(History *history, ReadServerHistoryChecks che
 }
 
 void MainWidget::unreadCountChanged(History *history) {
+	if (_updatesBatchLevel > 0) {
+		_batchedUnreadCountChanges.insert(history->peer->id);
+		return;
+	}
 	_history->unreadCountChanged(history);
 }
 
@@ -2331,7 +2347,7 @@ void MainWidget::fillPeerMenu(PeerData *peer, base::lambda<QAction*(const QStrin
 			if (update.peer != peer) return;
 			pinAction->setText(lang(App::history(peer)->isPinnedDialog() ? lng_context_unpin_from_top : lng_context_pin_to_top));
 		});
-		*pinSubscription = Notify::PeerUpdated().add_subscription(std::move(pinChangedHandler));
+		*pinSubscription = Notify::PeerUpdated(peer).add_subscription(std::move(pinChangedHandler));
 	}
 	callback(lang((peer->isChat() || peer->isMegagroup()) ? lng_context_view_group : (peer->isUser() ? lng_context_view_profile : lng_context_view_channel)), [peer] {
 		Ui::showPeerProfile(peer);
@@ -2344,7 +2360,7 @@ void MainWidget::fillPeerMenu(PeerData *peer, base::lambda<QAction*(const QStrin
 		if (update.peer != peer) return;
 		muteAction->setText(lang(peer->isMuted() ? lng_enable_notifications_from_tray : lng_disable_notifications_from_tray));
 	});
-	*muteSubscription = Notify::PeerUpdated().add_subscription(std::move(muteChangedHandler));
+	*muteSubscription = Notify::PeerUpdated(peer).add_subscription(std::move(muteChangedHandler));
 
 	callback(lang(lng_profile_search_messages), [peer] {
 		App::main()->searchInPeer(peer);
@@ -2403,7 +2419,7 @@ void MainWidget::fillPeerMenu(PeerData *peer, base::lambda<QAction*(const QStrin
 				if (update.peer != peer) return;
 				blockAction->setText(lang(peer->asUser()->isBlocked() ? (peer->asUser()->botInfo ? lng_profile_unblock_bot : lng_profile_unblock_user) : (peer->asUser()->botInfo ? lng_profile_block_bot : lng_profile_block_user)));
 			});
-			*blockSubscription = Notify::PeerUpdated().add_subscription(std::move(blockChangedHandler));
+			*blockSubscription = Notify::PeerUpdated(peer).add_subscription(std::move(blockChangedHandler));
 
 			if (user->blockStatus() == UserData::BlockStatus::Unknown) {
 				App::api()->requestFullPeer(user);
@@ -2476,6 +2492,19 @@ void MainWidget::createDialog(History *history) {
 	_dialogs->createDialog(history);
 }
 
+bool MainWidget::deferChatListUpdate(PeerData *peer, bool sortPositionChanged) {
+	if (_updatesBatchLevel <= 0) {
+		return false;
+	}
+	auto i = _batchedChatListUpdates.find(peer->id);
+	if (i == _batchedChatListUpdates.cend()) {
+		_batchedChatListUpdates.emplace(peer->id, sortPositionChanged);
+	} else if (sortPositionChanged) {
+		i->second = true;
+	}
+	return true;
+}
+
 void MainWidget::choosePeer(PeerId peerId, MsgId showAtMsgId) {
 	if (selectingPeer()) {
 		offerPeer(peerId);
@@ -2617,11 +2646,7 @@ void MainWidget::ui_showPeerHistory(quint64 peerId, qint32 showAtMsgId, Ui::Show
 			_wideSection = nullptr;
 		}
 		if (_overview) {
-			_overview->hide();
-			_overview->clear();
-			_overview->deleteLater();
-			_overview->rpcClear();
-			_overview = nullptr;
+			destroyOverview();
 		}
 	}
 
@@ -2715,6 +2740,24 @@ bool MainWidget::showMediaTypeSwitch() const {
 	return _overview ? _overview->showMediaTypeSwitch() : false;
 }
 
+void MainWidget::destroyOverview() {
+	// The overview history is kept loaded only while it is shown,
+	// so it is unloaded after the usual timeout from now.
+	auto peer = _overview->peer();
+	if (auto history = App::historyLoaded(peer)) {
+		history->setLastShownAt(getms());
+	}
+	if (auto migrated = peer->migrateFrom() ? App::historyLoaded(peer->migrateFrom()) : nullptr) {
+		migrated->setLastShownAt(getms());
+	}
+
+	_overview->hide();
+	_overview->clear();
+	_overview->deleteLater();
+	_overview->rpcClear();
+	_overview = nullptr;
+}
+
 void MainWidget::saveSectionInStack() {
 	if (_overview) {
 		_stack.push_back(std::make_unique<StackItemOverview>(_overview->peer(), _overview->type(), _overview->lastWidth(), _overview->lastScrollTop()));
@@ -2761,10 +2804,7 @@ void MainWidget::showMediaOverview(PeerData *peer, MediaOverviewType type, bool
 
 	setFocus(); // otherwise dialogs widget could be focused.
 	if (_overview) {
-		_overview->hide();
-		_overview->clear();
-		_overview->deleteLater();
-		_overview->rpcClear();
+		destroyOverview();
 	}
 	if (_wideSection) {
 		_wideSection->hide();
@@ -2929,11 +2969,7 @@ void MainWidget::showNewWideSection(const Window::SectionMemento *memento, bool
 
 	setFocus(); // otherwise dialogs widget could be focused.
 	if (_overview) {
-		_overview->hide();
-		_overview->clear();
-		_overview->deleteLater();
-		_overview->rpcClear();
-		_overview = nullptr;
+		destroyOverview();
 	}
 	if (_wideSection) {
 		_wideSection->hide();
@@ -3657,10 +3693,39 @@ void MainWidget::onUpdateNotifySettings() {
 }
 
 void MainWidget::feedUpdateVector(const MTPVector<MTPUpdate> &updates, bool skipMessageIds) {
+	startUpdatesBatch();
 	for_const (auto &update, updates.v) {
 		if (skipMessageIds && update.type() == mtpc_updateMessageID) continue;
 		feedUpdate(update);
 	}
+	finishUpdatesBatch();
+}
+
+void MainWidget::startUpdatesBatch() {
+	++_updatesBatchLevel;
+}
+
+void MainWidget::finishUpdatesBatch() {
+	Expects(_updatesBatchLevel > 0);
+	if (--_updatesBatchLevel > 0) {
+		return;
+	}
+
+	// Histories could be cleared while the updates were applied, so we look them up again.
+	for (auto peerId : base::take(_batchedUnreadCountChanges)) {
+		if (auto history = App::historyLoaded(peerId)) {
+			_history->unreadCountChanged(history);
+		}
+	}
+	for (auto &update : base::take(_batchedChatListUpdates)) {
+		if (auto history = App::historyLoaded(update.first)) {
+			if (update.second) {
+				history->updateChatListSortPosition();
+			} else {
+				history->updateChatListEntry();
+			}
+		}
+	}
 }
 
 void MainWidget::feedMessageIds(const MTPVector<MTPUpdate> &updates) {
@@ -3705,7 +3770,23 @@ void MainWidget::updSetState(int32 pts, int32 date, int32 qts, int32 seq) {
 	}
 }
 
+void MainWidget::channelDifferenceReceived(ChannelData *channel) {
+	_channelDifferencesSent.remove(channel);
+
+	// Apply all the differences received in one event loop iteration
+	// together, so that the chat list is updated only once for them.
+	if (!_channelDifferencesApplying) {
+		_channelDifferencesApplying = true;
+		startUpdatesBatch();
+		InvokeQueued(this, [this] {
+			_channelDifferencesApplying = false;
+			finishUpdatesBatch();
+		});
+	}
+}
+
 void MainWidget::gotChannelDifference(ChannelData *channel, const MTPupdates_ChannelDifference &diff) {
+	channelDifferenceReceived(channel);
 	_channelFailDifferenceTimeout.remove(channel);
 
 	int32 timeout = 0;
@@ -3755,6 +3836,7 @@ void MainWidget::gotChannelDifference(ChannelData *channel, const MTPupdates_Cha
 		App::feedChats(d.vchats);
 
 		_handlingChannelDifference = true;
+		startUpdatesBatch();
 		feedMessageIds(d.vother_updates);
 
 		// feed messages and groups, copy from App::feedMsgs
@@ -3788,6 +3870,7 @@ void MainWidget::gotChannelDifference(ChannelData *channel, const MTPupdates_Cha
 		}
 
 		feedUpdateVector(d.vother_updates, true);
+		finishUpdatesBatch();
 		_handlingChannelDifference = false;
 
 		if (d.has_timeout()) timeout = d.vtimeout.v;
@@ -3804,6 +3887,7 @@ void MainWidget::gotChannelDifference(ChannelData *channel, const MTPupdates_Cha
 	} else if (activePeer() == channel) {
 		channel->ptsWaitingForShortPoll(timeout ? (timeout * 1000) : WaitForChannelGetDifference);
 	}
+	sendChannelDifferenceRequests();
 }
 
 void MainWidget::gotRangeDifference(ChannelData *channel, const MTPupdates_ChannelDifference &diff) {
@@ -3833,9 +3917,11 @@ void MainWidget::gotRangeDifference(ChannelData *channel, const MTPupdates_Chann
 		App::feedChats(d.vchats);
 
 		_handlingChannelDifference = true;
+		startUpdatesBatch();
 		feedMessageIds(d.vother_updates);
 		App::feedMsgs(d.vnew_messages, NewMessageUnread);
 		feedUpdateVector(d.vother_updates, true);
+		finishUpdatesBatch();
 		_handlingChannelDifference = false;
 
 		nextRequestPts = d.vpts.v;
@@ -3854,8 +3940,10 @@ void MainWidget::gotRangeDifference(ChannelData *channel, const MTPupdates_Chann
 bool MainWidget::failChannelDifference(ChannelData *channel, const RPCError &error) {
 	if (MTP::isDefaultHandledError(error)) return false;
 
+	channelDifferenceReceived(channel);
 	LOG(("RPC Error in getChannelDifference: %1 %2: %3").arg(error.code()).arg(error.type()).arg(error.description()));
 	failDifferenceStartTimerFor(channel);
+	sendChannelDifferenceRequests();
 	return true;
 }
 
@@ -3998,9 +4086,11 @@ void MainWidget::feedDifference(const MTPVector<MTPUser> &users, const MTPVector
 	AuthSession::Current().checkAutoLock();
 	App::feedUsers(users);
 	App::feedChats(chats);
+	startUpdatesBatch();
 	feedMessageIds(other);
 	App::feedMsgs(msgs, NewMessageUnread);
 	feedUpdateVector(other, true);
+	finishUpdatesBatch();
 	_history->peerMessagesUpdated();
 }
 
@@ -4097,6 +4187,53 @@ void MainWidget::getChannelDifference(ChannelData *channel, ChannelDifferenceReq
 
 	channel->ptsSetRequesting(true);
 
+	_channelDifferencesQueued.insert(channel, from);
+	sendChannelDifferenceRequests();
+}
+
+void MainWidget::sendChannelDifferenceRequests() {
+	while (_channelDifferencesSent.size() < kChannelDifferenceRequestsLimit && !_channelDifferencesQueued.isEmpty()) {
+		auto best = _channelDifferencesQueued.begin();
+		auto bestPriority = channelDifferencePriority(best.key());
+		for (auto i = best + 1, e = _channelDifferencesQueued.end(); i != e; ++i) {
+			auto priority = channelDifferencePriority(i.key());
+			if (priority > bestPriority) {
+				best = i;
+				bestPriority = priority;
+			}
+		}
+		auto channel = best.key();
+		auto from = best.value();
+		_channelDifferencesQueued.erase(best);
+		sendChannelDifferenceRequest(channel, from);
+	}
+}
+
+int64 MainWidget::channelDifferencePriority(ChannelData *channel) {
+	// The opened channel goes first, then the not muted channels from
+	// the chats list, then the muted ones from the chats list. The mute
+	// state is checked directly, because the important chats list is
+	// maintained only while the dialogs mode is enabled.
+	// Inside each group the channels with more unread messages go first.
+	auto result = int64(0);
+	if (activePeer() == channel) {
+		result |= (1LL << 34);
+	}
+	if (auto history = App::historyLoaded(channel->id)) {
+		if (history->inChatList(Dialogs::Mode::All)) {
+			result |= (1LL << 32);
+			if (!history->mute()) {
+				result |= (1LL << 33);
+			}
+		}
+		result += history->unreadCount();
+	}
+	return result;
+}
+
+void MainWidget::sendChannelDifferenceRequest(ChannelData *channel, ChannelDifferenceRequest from) {
+	_channelDifferencesSent.insert(channel);
+
 	auto filter = MTP_channelMessagesFilterEmpty();
 	auto flags = qFlags(MTPupdates_GetChannelDifference::Flag::f_force);
 	if (from != ChannelDifferenceRequest::PtsGapOrShortPoll) {
@@ -4625,10 +4762,6 @@ void MainWidget::destroyData() {
 	_dialogs->destroyData();
 }
 
-void MainWidget::updateOnlineDisplayIn(int32 msecs) {
-	_onlineUpdater.start(msecs);
-}
-
 bool MainWidget::isActive() const {
 	return !_isIdle && isVisible() && !_a_show.animating();
 }
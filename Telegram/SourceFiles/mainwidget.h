@@ -24,6 +24,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "history/history_common.h"
 #include "core/single_timer.h"
 #include "base/weak_unique_ptr.h"
+#include "base/timer.h"
 
 namespace Notify {
 struct PeerUpdate;
@@ -185,6 +186,10 @@ public:
 
 	void createDialog(History *history);
 	void removeDialog(History *history);
+
+	// While a batch of updates is being applied the chat list rows are
+	// moved and repainted once per history when the batch is finished.
+	bool deferChatListUpdate(PeerData *peer, bool sortPositionChanged);
 	void dlgUpdated();
 	void dlgUpdated(Dialogs::Mode list, Dialogs::Row *row);
 	void dlgUpdated(PeerData *peer, MsgId msgId);
@@ -228,7 +233,6 @@ public:
 	bool onSendSticker(DocumentData *sticker);
 
 	void destroyData();
-	void updateOnlineDisplayIn(int32 msecs);
 
 	bool isActive() const;
 	bool doWeReadServerHistory() const;
@@ -349,6 +353,7 @@ public:
 	void pushReplyReturn(HistoryItem *item);
 
 	bool hasForwardingItems();
+	bool hasForwardingItemsFrom(gsl::not_null<History*> history) const;
 	void fillForwardingInfo(Text *&from, Text *&text, bool &serviceColor, ImagePtr &preview);
 	void cancelForwarding();
 	void finishForwarding(History *hist, bool silent); // send them
@@ -542,8 +547,13 @@ private:
 	void startWithSelf(const MTPVector<MTPUser> &users);
 
 	void saveSectionInStack();
+	void destroyOverview();
 
 	void getChannelDifference(ChannelData *channel, ChannelDifferenceRequest from = ChannelDifferenceRequest::Unknown);
+	void sendChannelDifferenceRequests();
+	void sendChannelDifferenceRequest(ChannelData *channel, ChannelDifferenceRequest from);
+	int64 channelDifferencePriority(ChannelData *channel);
+	void channelDifferenceReceived(ChannelData *channel);
 	void gotDifference(const MTPupdates_Difference &diff);
 	bool failDifference(const RPCError &e);
 	void feedDifference(const MTPVector<MTPUser> &users, const MTPVector<MTPChat> &chats, const MTPVector<MTPMessage> &msgs, const MTPVector<MTPUpdate> &other);
@@ -555,6 +565,8 @@ private:
 
 	void feedUpdateVector(const MTPVector<MTPUpdate> &updates, bool skipMessageIds = false);
 	void feedMessageIds(const MTPVector<MTPUpdate> &updates);
+	void startUpdatesBatch();
+	void finishUpdatesBatch();
 
 	void deleteHistoryPart(DeleteHistoryRequest request, const MTPmessages_AffectedHistory &result);
 	void deleteAllFromUserPart(DeleteAllFromUserParams params, const MTPmessages_AffectedHistory &result);
@@ -665,6 +677,11 @@ private:
 	PtsWaiter _ptsWaiter;
 
 	ChannelGetDifferenceTime _channelGetDifferenceTimeByPts, _channelGetDifferenceTimeAfterFail;
+
+	// Channel differences waiting for a free request slot and the ones in flight.
+	QMap<ChannelData*, ChannelDifferenceRequest> _channelDifferencesQueued;
+	OrderedSet<ChannelData*> _channelDifferencesSent;
+	bool _channelDifferencesApplying = false;
 	TimeMs _getDifferenceTimeByPts = 0;
 	TimeMs _getDifferenceTimeAfterFail = 0;
 
@@ -675,8 +692,10 @@ private:
 
 	SingleTimer _byMinChannelTimer;
 
+	base::Timer _unloadHistoriesTimer;
+
 	mtpRequestId _onlineRequest = 0;
-	SingleTimer _onlineTimer, _onlineUpdater, _idleFinishTimer;
+	SingleTimer _onlineTimer, _idleFinishTimer;
 	bool _lastWasOnline = false;
 	TimeMs _lastSetOnline = 0;
 	bool _isIdle = false;
@@ -700,6 +719,10 @@ private:
 	TimeMs _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
+	int _updatesBatchLevel = 0;
+	std::map<PeerId, bool> _batchedChatListUpdates; // Value is true if the sort position changed.
+	OrderedSet<PeerId> _batchedUnreadCountChanges;
+
 	QPixmap _cachedBackground;
 	QRect _cachedFor, _willCacheFor;
 	int _cachedX = 0;
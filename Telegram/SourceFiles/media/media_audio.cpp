@@ -617,6 +617,27 @@ void Mixer::play(const AudioMsgId &audio, int64 position) {
 	play(audio, std::unique_ptr<VideoSoundData>(), position);
 }
 
+void Mixer::prepare(const AudioMsgId &audio) {
+	Expects(audio.audio() != nullptr);
+
+	auto file = audio.audio()->location(true);
+	auto data = audio.audio()->data();
+	if (file.isEmpty() && data.isEmpty()) {
+		return;
+	}
+	auto loader = _loader;
+	InvokeQueued(loader, [loader, audio, file, data] {
+		loader->onPrepare(audio, file, data);
+	});
+}
+
+void Mixer::unprepare(AudioMsgId::Type type) {
+	auto loader = _loader;
+	InvokeQueued(loader, [loader, type] {
+		loader->onUnprepare(type);
+	});
+}
+
 void Mixer::play(const AudioMsgId &audio, std::unique_ptr<VideoSoundData> videoData, int64 position) {
 	Expects(!videoData || audio.playId() != 0);
 
@@ -994,6 +1015,8 @@ void Mixer::stopAndClear() {
 			clearAndCancel(AudioMsgId::Type::Song, index);
 		}
 		_videoTrack.clear();
+		unprepare(AudioMsgId::Type::Voice);
+		unprepare(AudioMsgId::Type::Song);
 	}
 }
 
@@ -1102,8 +1125,10 @@ void Fader::onTimer() {
 
 	auto volumeChangedAll = false;
 	auto volumeChangedSong = false;
+	auto suppressFading = false;
+	auto suppressWaitTill = TimeMs(0);
+	auto ms = getms();
 	if (_suppressAll || _suppressSongAnim) {
-		auto ms = getms();
 		if (_suppressAll) {
 			if (ms >= _suppressAllEnd || ms < _suppressAllStart) {
 				_suppressAll = _suppressAllAnim = false;
@@ -1111,13 +1136,20 @@ void Fader::onTimer() {
 			} else if (ms > _suppressAllEnd - kFadeDuration) {
 				if (_suppressVolumeAll.to() != 1.) _suppressVolumeAll.start(1.);
 				_suppressVolumeAll.update(1. - ((_suppressAllEnd - ms) / float64(kFadeDuration)), anim::linear);
+				suppressFading = true;
 			} else if (ms >= _suppressAllStart + st::mediaPlayerSuppressDuration) {
 				if (_suppressAllAnim) {
 					_suppressVolumeAll.finish();
 					_suppressAllAnim = false;
 				}
+
+				// The volume stays the same until the fade out before the end.
+				suppressWaitTill = _suppressAllEnd - kFadeDuration;
 			} else if (ms > _suppressAllStart) {
 				_suppressVolumeAll.update((ms - _suppressAllStart) / float64(st::mediaPlayerSuppressDuration), anim::linear);
+				suppressFading = true;
+			} else {
+				suppressFading = true;
 			}
 			auto wasVolumeMultiplierAll = VolumeMultiplierAll;
 			VolumeMultiplierAll = _suppressVolumeAll.current();
@@ -1129,6 +1161,7 @@ void Fader::onTimer() {
 				_suppressSongAnim = false;
 			} else {
 				_suppressVolumeSong.update((ms - _suppressSongStart) / float64(kFadeDuration), anim::linear);
+				suppressFading = true;
 			}
 		}
 		auto wasVolumeMultiplierSong = VolumeMultiplierSong;
@@ -1136,7 +1169,7 @@ void Fader::onTimer() {
 		accumulate_min(VolumeMultiplierSong, VolumeMultiplierAll);
 		volumeChangedSong = (VolumeMultiplierSong != wasVolumeMultiplierSong);
 	}
-	auto hasFading = (_suppressAll || _suppressSongAnim);
+	auto hasFading = suppressFading;
 	auto hasPlaying = false;
 
 	auto updatePlayback = [this, &hasPlaying, &hasFading](AudioMsgId::Type type, int index, float64 volumeMultiplier, bool suppressGainChanged) {
@@ -1161,11 +1194,19 @@ void Fader::onTimer() {
 
 	_volumeChangedSong = _volumeChangedVideo = false;
 
+	// Gain ramps need frequent updates, otherwise wake up only for the
+	// position checks and for the next suppression volume change.
 	if (hasFading) {
+		_timer.setTimerType(Qt::PreciseTimer);
 		_timer.start(kCheckFadingTimeout);
 		Audio::StopDetachIfNotUsedSafe();
-	} else if (hasPlaying) {
-		_timer.start(kCheckPlaybackPositionTimeout);
+	} else if (hasPlaying || _suppressAll) {
+		auto timeout = hasPlaying ? kCheckPlaybackPositionTimeout : (suppressWaitTill - ms);
+		if (suppressWaitTill) {
+			accumulate_min(timeout, suppressWaitTill - ms);
+		}
+		_timer.setTimerType(Qt::CoarseTimer);
+		_timer.start(qMax(timeout, kCheckFadingTimeout));
 		Audio::StopDetachIfNotUsedSafe();
 	} else {
 		Audio::ScheduleDetachIfNotUsedSafe();
@@ -1515,13 +1556,22 @@ public:
 
 		auto fmt = format();
 		auto peak = uint16(0);
-		auto callback = [&peak, &sumbytes, &peaks, countbytes](uint16 sample) {
-			accumulate_max(peak, sample);
-			sumbytes += Media::Player::kWaveformSamplesCount;
-			if (sumbytes >= countbytes) {
-				sumbytes -= countbytes;
-				peaks.push_back(peak);
-				peak = 0;
+		auto countPeaks = [&peak, &sumbytes, &peaks, countbytes](auto samples, int64 count) {
+			constexpr auto kStep = int64(Media::Player::kWaveformSamplesCount);
+			while (count > 0) {
+				// Each sample adds kStep to sumbytes, find where the current peak ends
+				// and reduce the whole range at once instead of checking every sample.
+				auto tillPeakEnd = (countbytes - sumbytes + kStep - 1) / kStep;
+				auto chunk = qMin(tillPeakEnd, count);
+				accumulate_max(peak, Media::Audio::ReadMaxSample(samples, chunk));
+				samples += chunk;
+				count -= chunk;
+				sumbytes += chunk * kStep;
+				if (sumbytes >= countbytes) {
+					sumbytes -= countbytes;
+					peaks.push_back(peak);
+					peak = 0;
+				}
 			}
 		};
 		while (processed < countbytes) {
@@ -1536,11 +1586,10 @@ public:
 				continue;
 			}
 
-			auto sampleBytes = gsl::as_bytes(gsl::make_span(buffer));
 			if (fmt == AL_FORMAT_MONO8 || fmt == AL_FORMAT_STEREO8) {
-				Media::Audio::IterateSamples<uchar>(sampleBytes, callback);
+				countPeaks(reinterpret_cast<const uchar*>(buffer.constData()), int64(buffer.size()));
 			} else if (fmt == AL_FORMAT_MONO16 || fmt == AL_FORMAT_STEREO16) {
-				Media::Audio::IterateSamples<int16>(sampleBytes, callback);
+				countPeaks(reinterpret_cast<const int16*>(buffer.constData()), int64(buffer.size() / sizeof(int16)));
 			}
 			processed += sampleSize * samples;
 		}
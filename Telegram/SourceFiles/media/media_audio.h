@@ -123,6 +123,11 @@ public:
 
 	void play(const AudioMsgId &audio, int64 position = 0);
 	void play(const AudioMsgId &audio, std::unique_ptr<VideoSoundData> videoData, int64 position = 0);
+
+	// Opens the track and decodes its beginning, so that a following
+	// play() of it from the start doesn't wait for the decoder.
+	void prepare(const AudioMsgId &audio);
+	void unprepare(AudioMsgId::Type type);
 	void pause(const AudioMsgId &audio, bool fast = false);
 	void resume(const AudioMsgId &audio, bool fast = false);
 	void seek(AudioMsgId::Type type, int64 position); // type == AudioMsgId::Type::Song
@@ -354,5 +359,15 @@ void IterateSamples(base::const_byte_span bytes, Callback &&callback) {
 	}
 }
 
+// A branchless loop that compilers turn into packed abs / max instructions.
+template <typename SampleType>
+uint16 ReadMaxSample(const SampleType *samples, int64 count) {
+	auto result = uint16(0);
+	for (auto i = int64(0); i != count; ++i) {
+		accumulate_max(result, ReadOneSample(samples[i]));
+	}
+	return result;
+}
+
 } // namespace Audio
 } // namespace Media
@@ -111,7 +111,50 @@ void Loaders::onStart(const AudioMsgId &audio, qint64 position) {
 		track->loading = true;
 	}
 
+	auto startedAt = getms();
+	auto prepared = (_prepared == audio);
 	loadData(audio, position);
+	DEBUG_LOG(("Audio Info: first samples queued in %1ms, prepared: %2").arg(getms() - startedAt).arg(Logs::b(prepared)));
+
+	// Another track of this type has started, the prepared one is stale.
+	onUnprepare(type);
+}
+
+void Loaders::onPrepare(const AudioMsgId &audio, const FileLocation &file, const QByteArray &data) {
+	if (_prepared == audio) {
+		return;
+	}
+	_prepared = AudioMsgId();
+	_preparedLoader = nullptr;
+
+	auto loader = std::make_unique<FFMpegLoader>(file, data, base::byte_vector());
+	auto position = qint64(0);
+	if (!loader->open(position) || loader->samplesCount() <= 0) {
+		return;
+	}
+
+	QByteArray samples;
+	int64 samplesCount = 0;
+	while (samples.size() < AudioVoiceMsgBufferSize) {
+		auto res = loader->readMore(samples, samplesCount);
+		using Result = AudioPlayerLoader::ReadResult;
+		if (res == Result::Error) {
+			return;
+		} else if (res != Result::Ok) {
+			break;
+		}
+	}
+	loader->saveDecodedSamples(&samples, &samplesCount);
+
+	_prepared = audio;
+	_preparedLoader = std::move(loader);
+}
+
+void Loaders::onUnprepare(AudioMsgId::Type type) {
+	if (_prepared && _prepared.type() == type) {
+		_prepared = AudioMsgId();
+		_preparedLoader = nullptr;
+	}
 }
 
 AudioMsgId Loaders::clear(AudioMsgId::Type type) {
@@ -325,6 +368,7 @@ AudioPlayerLoader *Loaders::setupLoader(const AudioMsgId &audio, SetupError &err
 		case AudioMsgId::Type::Video: _video = audio; loader = &_videoLoader; break;
 		}
 
+		auto opened = false;
 		if (audio.playId()) {
 			if (!track->videoData) {
 				clear(audio.type());
@@ -334,12 +378,16 @@ AudioPlayerLoader *Loaders::setupLoader(const AudioMsgId &audio, SetupError &err
 				return nullptr;
 			}
 			*loader = std::make_unique<ChildFFMpegLoader>(std::move(track->videoData));
+		} else if (_prepared == audio && !position && _preparedLoader->check(track->file, track->data)) {
+			*loader = std::move(_preparedLoader);
+			_prepared = AudioMsgId();
+			opened = true;
 		} else {
 			*loader = std::make_unique<FFMpegLoader>(track->file, track->data, base::byte_vector());
 		}
 		l = loader->get();
 
-		if (!l->open(position)) {
+		if (!opened && !l->open(position)) {
 			track->state.state = State::StoppedAtStart;
 			return nullptr;
 		}
@@ -387,6 +435,7 @@ void Loaders::onCancel(const AudioMsgId &audio) {
 	case AudioMsgId::Type::Song: if (_song == audio) clear(audio.type()); break;
 	case AudioMsgId::Type::Video: if (_video == audio) clear(audio.type()); break;
 	}
+	onUnprepare(audio.type());
 
 	QMutexLocker lock(internal::audioPlayerMutex());
 	if (!mixer()) return;
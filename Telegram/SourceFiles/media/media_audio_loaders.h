@@ -36,6 +36,10 @@ class Loaders : public QObject {
 public:
 	Loaders(QThread *thread);
 	void feedFromVideo(VideoSoundPart &&part);
+
+	// Thread: Loaders.
+	void onPrepare(const AudioMsgId &audio, const FileLocation &file, const QByteArray &data);
+	void onUnprepare(AudioMsgId::Type type);
 	~Loaders();
 
 signals:
@@ -58,6 +62,10 @@ private:
 	std::unique_ptr<AudioPlayerLoader> _songLoader;
 	std::unique_ptr<AudioPlayerLoader> _videoLoader;
 
+	// The next track opened ahead of time with its first buffer decoded.
+	AudioMsgId _prepared;
+	std::unique_ptr<AudioPlayerLoader> _preparedLoader;
+
 	QMutex _fromVideoMutex;
 	QMap<AudioMsgId, QQueue<FFMpeg::AVPacketDataWrap>> _fromVideoQueues;
 	SingleQueuedInvokation _fromVideoNotify;
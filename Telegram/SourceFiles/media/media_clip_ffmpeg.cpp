@@ -23,6 +23,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "media/media_audio.h"
 #include "media/media_child_ffmpeg_loader.h"
 
+#include <zlib.h>
+
 namespace Media {
 namespace Clip {
 namespace internal {
@@ -30,34 +32,97 @@ namespace {
 
 constexpr int kSkipInvalidDataPackets = 10;
 constexpr int kAlignImageBy = 16;
+constexpr int kFrameBuffersPoolSize = 4;
+constexpr int kMaxDecodeThreads = 4;
+constexpr int kThreadedDecodeMinPixels = 640 * 360;
+constexpr int kLoopCacheAttempts = 3;
+constexpr TimeMs kLoopCacheMaxDurationMs = 10000;
+constexpr int64 kLoopCacheMaxBytes = 8 * 1024 * 1024;
+
+// All the loop caches together, zero turns the caching off.
+constexpr int kLoopCacheTotalMaxBytes = 48 * 1024 * 1024;
+QAtomicInt LoopCacheTotalBytes;
 
-void alignedImageBufferCleanupHandler(void *data) {
-	auto buffer = static_cast<uchar*>(data);
-	delete[] buffer;
+bool isAlignedImage(const QImage &image) {
+	return !(reinterpret_cast<uintptr_t>(image.constBits()) % kAlignImageBy) && !(image.bytesPerLine() % kAlignImageBy);
 }
 
-// Create a QImage of desired size where all the data is aligned to 16 bytes.
-QImage createAlignedImage(QSize size) {
+} // namespace
+
+// Frame images are released both in the clip thread and in the main
+// thread (with the pixmaps made from them), so the buffers are returned
+// here and reused for the next frames instead of allocating new ones.
+class FrameBufferPool : public std::enable_shared_from_this<FrameBufferPool> {
+public:
+	// Create a QImage of desired size where all the data is aligned to 16 bytes.
+	QImage createAlignedImage(QSize size);
+
+	~FrameBufferPool();
+
+private:
+	struct Buffer {
+		std::shared_ptr<FrameBufferPool> pool;
+		uchar *data = nullptr;
+		int size = 0;
+	};
+	static void CleanupHandler(void *info);
+	void release(uchar *data, int size);
+
+	QMutex _mutex;
+	std::vector<std::pair<uchar*, int>> _free;
+
+};
+
+QImage FrameBufferPool::createAlignedImage(QSize size) {
 	auto width = size.width();
 	auto height = size.height();
 	auto widthalign = kAlignImageBy / 4;
 	auto neededwidth = width + ((width % widthalign) ? (widthalign - (width % widthalign)) : 0);
 	auto bytesperline = neededwidth * 4;
-	auto buffer = new uchar[bytesperline * height + kAlignImageBy];
-	auto cleanupdata = static_cast<void*>(buffer);
-	auto bufferval = reinterpret_cast<uintptr_t>(buffer);
-	auto alignedbuffer = buffer + ((bufferval % kAlignImageBy) ? (kAlignImageBy - (bufferval % kAlignImageBy)) : 0);
-	return QImage(alignedbuffer, width, height, bytesperline, QImage::Format_ARGB32, alignedImageBufferCleanupHandler, cleanupdata);
+	auto buffer = std::make_unique<Buffer>();
+	buffer->pool = shared_from_this();
+	buffer->size = bytesperline * height + kAlignImageBy;
+	{
+		QMutexLocker lock(&_mutex);
+		for (auto i = _free.begin(), e = _free.end(); i != e; ++i) {
+			if (i->second == buffer->size) {
+				buffer->data = i->first;
+				_free.erase(i);
+				break;
+			}
+		}
+	}
+	if (!buffer->data) {
+		buffer->data = new uchar[buffer->size];
+	}
+	auto bufferval = reinterpret_cast<uintptr_t>(buffer->data);
+	auto alignedbuffer = buffer->data + ((bufferval % kAlignImageBy) ? (kAlignImageBy - (bufferval % kAlignImageBy)) : 0);
+	return QImage(alignedbuffer, width, height, bytesperline, QImage::Format_ARGB32, &FrameBufferPool::CleanupHandler, static_cast<void*>(buffer.release()));
 }
 
-bool isAlignedImage(const QImage &image) {
-	return !(reinterpret_cast<uintptr_t>(image.constBits()) % kAlignImageBy) && !(image.bytesPerLine() % kAlignImageBy);
+void FrameBufferPool::CleanupHandler(void *info) {
+	auto buffer = std::unique_ptr<Buffer>(static_cast<Buffer*>(info));
+	buffer->pool->release(buffer->data, buffer->size);
 }
 
-} // namespace
+void FrameBufferPool::release(uchar *data, int size) {
+	QMutexLocker lock(&_mutex);
+	if (_free.size() < kFrameBuffersPoolSize) {
+		_free.push_back(std::make_pair(data, size));
+	} else {
+		delete[] data;
+	}
+}
+
+FrameBufferPool::~FrameBufferPool() {
+	for (auto &buffer : _free) {
+		delete[] buffer.first;
+	}
+}
 
 FFMpegReaderImplementation::FFMpegReaderImplementation(FileLocation *location, QByteArray *data, const AudioMsgId &audio) : ReaderImplementation(location, data)
-, _audioMsgId(audio) {
+, _audioMsgId(audio)
+, _framePool(std::make_shared<FrameBufferPool>()) {
 	_frame = av_frame_alloc();
 	av_init_packet(&_packetNull);
 	_packetNull.data = nullptr;
@@ -65,9 +130,17 @@ FFMpegReaderImplementation::FFMpegReaderImplementation(FileLocation *location, Q
 }
 
 ReaderImplementation::ReadResult FFMpegReaderImplementation::readNextFrame() {
+	if (_loopCacheReady) {
+		return readCachedFrame();
+	}
 	if (_frameRead) {
 		av_frame_unref(_frame);
 		_frameRead = false;
+
+		// The frame was skipped without rendering, we can't cache this loop.
+		if (_loopCacheRecording) {
+			dropLoopCache();
+		}
 	}
 
 	do {
@@ -86,23 +159,21 @@ ReaderImplementation::ReadResult FFMpegReaderImplementation::readNextFrame() {
 				LOG(("Gif Error: Got EOF before a single frame was read!"));
 				return ReadResult::Error;
 			}
+			if (_loopCacheRecording) {
+				// The whole loop was rendered, play the next ones from the cache.
+				_loopCacheRecording = false;
+				_loopCacheReady = true;
+				_loopCacheIndex = int(_loopCache.size()) - 1;
+				avcodec_flush_buffers(_codecContext);
+				return readCachedFrame();
+			}
 
-			if ((res = avformat_seek_file(_fmtContext, _streamId, std::numeric_limits<int64_t>::min(), 0, std::numeric_limits<int64_t>::max(), 0)) < 0) {
-				if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_BYTE)) < 0) {
-					if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_FRAME)) < 0) {
-						if ((res = av_seek_frame(_fmtContext, _streamId, 0, 0)) < 0) {
-							char err[AV_ERROR_MAX_STRING_SIZE] = { 0 };
-							LOG(("Gif Error: Unable to av_seek_frame() to the start %1, error %2, %3").arg(logData()).arg(res).arg(av_make_error_string(err, sizeof(err), res)));
-							return ReadResult::Error;
-						}
-					}
-				}
+			if (!rewindToStart()) {
+				return ReadResult::Error;
+			}
+			if (loopCacheAllowed()) {
+				startLoopCache();
 			}
-			avcodec_flush_buffers(_codecContext);
-			_hadFrame = false;
-			_frameMs = 0;
-			_lastReadVideoMs = _lastReadAudioMs = 0;
-			_skippedInvalidDataPackets = 0;
 
 			continue;
 		} else if (res != AVERROR(EAGAIN)) {
@@ -151,18 +222,27 @@ void FFMpegReaderImplementation::processReadFrame() {
 	int64 duration = av_frame_get_pkt_duration(_frame);
 	int64 framePts = _frame->pts;
 	TimeMs frameMs = (framePts * 1000LL * _fmtContext->streams[_streamId]->time_base.num) / _fmtContext->streams[_streamId]->time_base.den;
+	auto nextFrameDelay = 0;
+	if (duration != AV_NOPTS_VALUE) {
+		nextFrameDelay = (duration * 1000LL * _fmtContext->streams[_streamId]->time_base.num) / _fmtContext->streams[_streamId]->time_base.den;
+	}
+	if (_loopCacheRecording) {
+		auto frame = CachedFrame();
+		frame.frameMs = frameMs;
+		frame.nextFrameDelay = nextFrameDelay;
+		_loopCache.push_back(std::move(frame));
+	}
+	processFrameTime(frameMs, nextFrameDelay);
+}
+
+void FFMpegReaderImplementation::processFrameTime(TimeMs frameMs, int nextFrameDelay) {
 	_currentFrameDelay = _nextFrameDelay;
 	if (_frameMs + _currentFrameDelay < frameMs) {
 		_currentFrameDelay = int32(frameMs - _frameMs);
 	} else if (frameMs < _frameMs + _currentFrameDelay) {
 		frameMs = _frameMs + _currentFrameDelay;
 	}
-
-	if (duration == AV_NOPTS_VALUE) {
-		_nextFrameDelay = 0;
-	} else {
-		_nextFrameDelay = (duration * 1000LL * _fmtContext->streams[_streamId]->time_base.num) / _fmtContext->streams[_streamId]->time_base.den;
-	}
+	_nextFrameDelay = nextFrameDelay;
 	_frameMs = frameMs;
 
 	_hadFrame = _frameRead = true;
@@ -219,6 +299,10 @@ TimeMs FFMpegReaderImplementation::durationMs() const {
 }
 
 bool FFMpegReaderImplementation::renderFrame(QImage &to, bool &hasAlpha, const QSize &size) {
+	if (_loopCacheReady) {
+		return renderCachedFrame(to, hasAlpha, size);
+	}
+
 	Expects(_frameRead);
 	_frameRead = false;
 
@@ -235,7 +319,7 @@ bool FFMpegReaderImplementation::renderFrame(QImage &to, bool &hasAlpha, const Q
 		toSize.transpose();
 	}
 	if (to.isNull() || to.size() != toSize || !to.isDetached() || !isAlignedImage(to)) {
-		to = createAlignedImage(toSize);
+		to = _framePool->createAlignedImage(toSize);
 	}
 	hasAlpha = (_frame->format == AV_PIX_FMT_BGRA || (_frame->format == -1 && _codecContext->pix_fmt == AV_PIX_FMT_BGRA));
 	if (_frame->width == toSize.width() && _frame->height == toSize.height() && hasAlpha) {
@@ -267,6 +351,9 @@ bool FFMpegReaderImplementation::renderFrame(QImage &to, bool &hasAlpha, const Q
 		}
 		to = to.transformed(rotationTransform);
 	}
+	if (_loopCacheRecording) {
+		storeCachedFrame(to, hasAlpha);
+	}
 
 	// Read some future packets for audio stream.
 	if (_audioStreamId >= 0) {
@@ -355,6 +442,15 @@ bool FFMpegReaderImplementation::start(Mode mode, TimeMs &positionMs) {
 
 	_codec = avcodec_find_decoder(_codecContext->codec_id);
 
+	// Decode large frames in several threads, small GIFs are cheap enough
+	// and we already have ClipThreadsCount threads decoding them in parallel.
+	if (_codecContext->width * _codecContext->height >= kThreadedDecodeMinPixels) {
+		_codecContext->thread_count = qBound(1, QThread::idealThreadCount(), kMaxDecodeThreads);
+		_codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+	} else {
+		_codecContext->thread_count = 1;
+	}
+
 	_audioStreamId = av_find_best_stream(_fmtContext, AVMEDIA_TYPE_AUDIO, -1, -1, 0, 0);
 	if (_mode == Mode::Inspecting) {
 		_hasAudioStream = (_audioStreamId >= 0);
@@ -422,6 +518,163 @@ bool FFMpegReaderImplementation::start(Mode mode, TimeMs &positionMs) {
 		processPacket(&packet);
 	}
 
+	if (positionMs <= 0 && loopCacheAllowed()) {
+		startLoopCache();
+	}
+
+	return true;
+}
+
+bool FFMpegReaderImplementation::rewindToStart() {
+	auto res = 0;
+	if ((res = avformat_seek_file(_fmtContext, _streamId, std::numeric_limits<int64_t>::min(), 0, std::numeric_limits<int64_t>::max(), 0)) < 0) {
+		if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_BYTE)) < 0) {
+			if ((res = av_seek_frame(_fmtContext, _streamId, 0, AVSEEK_FLAG_FRAME)) < 0) {
+				if ((res = av_seek_frame(_fmtContext, _streamId, 0, 0)) < 0) {
+					char err[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+					LOG(("Gif Error: Unable to av_seek_frame() to the start %1, error %2, %3").arg(logData()).arg(res).arg(av_make_error_string(err, sizeof(err), res)));
+					return false;
+				}
+			}
+		}
+	}
+	avcodec_flush_buffers(_codecContext);
+	_hadFrame = false;
+	_frameMs = 0;
+	_lastReadVideoMs = _lastReadAudioMs = 0;
+	_skippedInvalidDataPackets = 0;
+	return true;
+}
+
+bool FFMpegReaderImplementation::loopCacheAllowed() const {
+	if (_mode != Mode::Silent || _audioStreamId >= 0 || _loopCacheAttempts >= kLoopCacheAttempts) {
+		return false;
+	} else if (LoopCacheTotalBytes.loadAcquire() >= kLoopCacheTotalMaxBytes) {
+		return false;
+	}
+	auto duration = durationMs();
+	return (duration > 0 && duration <= kLoopCacheMaxDurationMs);
+}
+
+void FFMpegReaderImplementation::startLoopCache() {
+	dropLoopCache();
+	++_loopCacheAttempts;
+	_loopCacheRecording = true;
+}
+
+void FFMpegReaderImplementation::dropLoopCache() {
+	_loopCacheRecording = false;
+	_loopCacheReady = false;
+	_loopCache = std::vector<CachedFrame>();
+	LoopCacheTotalBytes.fetchAndAddOrdered(-int(_loopCacheBytes));
+	_loopCacheBytes = 0;
+}
+
+void FFMpegReaderImplementation::storeCachedFrame(const QImage &image, bool hasAlpha) {
+	Expects(!_loopCache.empty());
+
+	auto &frame = _loopCache.back();
+	if (_loopCache.size() > 1 && _loopCache.front().size != image.size()) {
+		// The size has changed while recording, all frames should be the same.
+		dropLoopCache();
+		return;
+	}
+	auto size = uLong(image.bytesPerLine()) * image.height();
+	auto compressedSize = compressBound(size);
+	frame.data.resize(int(compressedSize));
+	auto res = compress2(reinterpret_cast<Bytef*>(frame.data.data()), &compressedSize, image.constBits(), size, Z_BEST_SPEED);
+	if (res != Z_OK) {
+		LOG(("Gif Error: Unable to compress2() a frame %1, error %2").arg(logData()).arg(res));
+		dropLoopCache();
+		_loopCacheAttempts = kLoopCacheAttempts;
+		return;
+	}
+	frame.data.resize(int(compressedSize));
+	frame.data.squeeze();
+	frame.size = image.size();
+	frame.bytesPerLine = image.bytesPerLine();
+	frame.alpha = hasAlpha;
+
+	_loopCacheBytes += frame.data.size();
+	auto totalBytes = LoopCacheTotalBytes.fetchAndAddOrdered(frame.data.size()) + frame.data.size();
+	if (_loopCacheBytes > kLoopCacheMaxBytes) {
+		// Too large to keep in memory, don't try it again.
+		dropLoopCache();
+		_loopCacheAttempts = kLoopCacheAttempts;
+	} else if (totalBytes > kLoopCacheTotalMaxBytes) {
+		// Other clips use the whole budget, try again in the next loop.
+		dropLoopCache();
+	}
+}
+
+ReaderImplementation::ReadResult FFMpegReaderImplementation::readCachedFrame() {
+	_loopCacheIndex = (_loopCacheIndex + 1) % int(_loopCache.size());
+	if (!_loopCacheIndex) {
+		_frameMs = 0; // Same as after seeking to the start.
+	}
+	auto &frame = _loopCache[_loopCacheIndex];
+	processFrameTime(frame.frameMs, frame.nextFrameDelay);
+	return ReadResult::Success;
+}
+
+bool FFMpegReaderImplementation::renderCachedFrame(QImage &to, bool &hasAlpha, const QSize &size) {
+	Expects(_frameRead);
+	_frameRead = false;
+
+	auto &frame = _loopCache[_loopCacheIndex];
+	auto wantedSize = size.isEmpty() ? frame.size : size;
+	if (wantedSize != frame.size) {
+		// The frames were cached in a different size. Scale this one and
+		// decode the next ones in the new size, caching them once again.
+		auto unscaled = _framePool->createAlignedImage(frame.size);
+		if (!uncompressCachedFrame(frame, unscaled)) {
+			return false;
+		}
+		to = unscaled.scaled(wantedSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		hasAlpha = frame.alpha;
+
+		dropLoopCache();
+		if (!rewindToStart()) {
+			return false;
+		}
+		if (loopCacheAllowed()) {
+			startLoopCache();
+		}
+		return true;
+	} else {
+		if (to.isNull() || to.size() != frame.size || !to.isDetached() || !isAlignedImage(to)) {
+			to = _framePool->createAlignedImage(frame.size);
+		}
+		if (!uncompressCachedFrame(frame, to)) {
+			return false;
+		}
+	}
+	hasAlpha = frame.alpha;
+	return true;
+}
+
+bool FFMpegReaderImplementation::uncompressCachedFrame(const CachedFrame &frame, QImage &to) {
+	auto size = uLong(frame.bytesPerLine) * frame.size.height();
+	auto uncompressedSize = size;
+	auto res = Z_OK;
+	if (to.bytesPerLine() == frame.bytesPerLine) {
+		res = uncompress(to.bits(), &uncompressedSize, reinterpret_cast<const Bytef*>(frame.data.constData()), frame.data.size());
+	} else {
+		auto buffer = QByteArray(int(size), Qt::Uninitialized);
+		res = uncompress(reinterpret_cast<Bytef*>(buffer.data()), &uncompressedSize, reinterpret_cast<const Bytef*>(frame.data.constData()), frame.data.size());
+		if (res == Z_OK) {
+			auto bytesPerLine = qMin(frame.bytesPerLine, to.bytesPerLine());
+			auto from = reinterpret_cast<const uchar*>(buffer.constData());
+			auto bits = to.bits();
+			for (auto y = 0, height = frame.size.height(); y != height; ++y) {
+				memcpy(bits + y * to.bytesPerLine(), from + y * frame.bytesPerLine, bytesPerLine);
+			}
+		}
+	}
+	if (res != Z_OK || uncompressedSize != size) {
+		LOG(("Gif Error: Unable to uncompress() a cached frame %1, error %2").arg(logData()).arg(res));
+		return false;
+	}
 	return true;
 }
 
@@ -469,6 +722,7 @@ QString FFMpegReaderImplementation::logData() const {
 
 FFMpegReaderImplementation::~FFMpegReaderImplementation() {
 	clearPacketQueue();
+	dropLoopCache();
 
 	if (_frameRead) {
 		av_frame_unref(_frame);
@@ -33,6 +33,8 @@ namespace Media {
 namespace Clip {
 namespace internal {
 
+class FrameBufferPool;
+
 class FFMpegReaderImplementation : public ReaderImplementation {
 public:
 	FFMpegReaderImplementation(FileLocation *location, QByteArray *data, const AudioMsgId &audio);
@@ -61,6 +63,27 @@ public:
 private:
 	ReadResult readNextFrame();
 	void processReadFrame();
+	void processFrameTime(TimeMs frameMs, int nextFrameDelay);
+
+	// Short silent clips keep their rendered frames compressed after
+	// one loop was fully rendered, so that the next loops don't decode
+	// and scale the same frames again.
+	struct CachedFrame {
+		TimeMs frameMs = 0;
+		int nextFrameDelay = 0;
+		QSize size;
+		int bytesPerLine = 0;
+		bool alpha = false;
+		QByteArray data; // zlib compressed pixels
+	};
+	bool loopCacheAllowed() const;
+	bool rewindToStart();
+	void startLoopCache();
+	void storeCachedFrame(const QImage &image, bool hasAlpha);
+	void dropLoopCache();
+	ReadResult readCachedFrame();
+	bool renderCachedFrame(QImage &to, bool &hasAlpha, const QSize &size);
+	bool uncompressCachedFrame(const CachedFrame &frame, QImage &to);
 
 	enum class PacketResult {
 		Ok,
@@ -122,6 +145,7 @@ private:
 	int _height = 0;
 	SwsContext *_swsContext = nullptr;
 	QSize _swsSize;
+	std::shared_ptr<FrameBufferPool> _framePool;
 
 	TimeMs _frameMs = 0;
 	int _nextFrameDelay = 0;
@@ -130,6 +154,13 @@ private:
 	TimeMs _frameTime = 0;
 	TimeMs _frameTimeCorrection = 0;
 
+	std::vector<CachedFrame> _loopCache;
+	int64 _loopCacheBytes = 0;
+	int _loopCacheAttempts = 0;
+	int _loopCacheIndex = 0;
+	bool _loopCacheRecording = false;
+	bool _loopCacheReady = false;
+
 };
 
 } // namespace internal
@@ -20,11 +20,38 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 */
 #include "media/media_clip_implementation.h"
 
+#include "storage/streamed_file.h"
+
 namespace Media {
 namespace Clip {
 namespace internal {
 
+StreamedDevice::StreamedDevice(std::shared_ptr<Storage::StreamedFile> file, const QAtomicInt &interrupted)
+: _file(std::move(file))
+, _interrupted(interrupted) {
+}
+
+bool StreamedDevice::open(OpenMode mode) {
+	// No QIODevice buffering: FFmpeg has its own and we read parts by offset.
+	return QIODevice::open(mode | QIODevice::Unbuffered);
+}
+
+qint64 StreamedDevice::size() const {
+	return _file->size();
+}
+
+qint64 StreamedDevice::readData(char *data, qint64 maxSize) {
+	auto size = int(qMin(maxSize, qint64(std::numeric_limits<int>::max())));
+	return _file->read(int(pos()), data, size, _interrupted);
+}
+
 void ReaderImplementation::initDevice() {
+	if (_streamed) {
+		if (_streamed->isOpen()) _streamed->close();
+		_dataSize = _streamed->size();
+		_device = _streamed.get();
+		return;
+	}
 	if (_data->isEmpty()) {
 		if (_file.isOpen()) _file.close();
 		_file.setFileName(_location->name());
@@ -22,10 +22,39 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 class FileLocation;
 
+namespace Storage {
+class StreamedFile;
+} // namespace Storage
+
 namespace Media {
 namespace Clip {
 namespace internal {
 
+// Random access device over a file that is still being downloaded.
+// Reading blocks until the requested part arrives or the reader is
+// interrupted, so it should be used only from the clip threads.
+class StreamedDevice : public QIODevice {
+public:
+	StreamedDevice(std::shared_ptr<Storage::StreamedFile> file, const QAtomicInt &interrupted);
+
+	bool open(OpenMode mode) override;
+	bool isSequential() const override {
+		return false;
+	}
+	qint64 size() const override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+	qint64 writeData(const char *data, qint64 maxSize) override {
+		return -1;
+	}
+
+private:
+	std::shared_ptr<Storage::StreamedFile> _file;
+	const QAtomicInt &_interrupted;
+
+};
+
 class ReaderImplementation {
 public:
 	ReaderImplementation(FileLocation *location, QByteArray *data)
@@ -64,11 +93,17 @@ public:
 		return _dataSize;
 	}
 
+	// Read the file parts while it is still loading instead of _location.
+	void setStreamed(std::shared_ptr<Storage::StreamedFile> streamed, const QAtomicInt &interrupted) {
+		_streamed = std::make_unique<StreamedDevice>(std::move(streamed), interrupted);
+	}
+
 protected:
 	FileLocation *_location;
 	QByteArray *_data;
 	QFile _file;
 	QBuffer _buffer;
+	std::unique_ptr<StreamedDevice> _streamed;
 	QIODevice *_device = nullptr;
 	int64 _dataSize = 0;
 
@@ -29,6 +29,8 @@ extern "C" {
 
 #include "media/media_clip_ffmpeg.h"
 #include "media/media_clip_qtgif.h"
+#include "storage/streamed_file.h"
+#include "base/task_queue.h"
 #include "mainwidget.h"
 #include "mainwindow.h"
 
@@ -36,9 +38,38 @@ namespace Media {
 namespace Clip {
 namespace {
 
+constexpr auto kLoadCostAveraging = 8;
+constexpr auto kSharedPixCacheLimit = 64 * 1024 * 1024;
+constexpr auto kEstimatedPixelsPerMicrosecond = 100;
+constexpr auto kEstimatedFrameDelayMs = 40;
+
 QVector<QThread*> threads;
 QVector<Manager*> managers;
 
+// The same managers, but safe to be read from the clip threads.
+std::array<QAtomicPointer<Manager>, ClipThreadsCount> stealTargets;
+
+// Decoding readers of the animated documents shown in several places.
+struct SharedGif {
+	std::unique_ptr<Reader> source;
+	std::vector<Reader*> views;
+};
+std::map<DocumentData*, SharedGif> SharedGifs;
+
+// Memory used by the views that show a shared GIF in a different size.
+int64 SharedPixCacheSize = 0;
+
+int64 PixmapBytes(const QPixmap &pix) {
+	return int64(pix.width()) * pix.height() * 4;
+}
+
+// Decoding work in microseconds per second of playback for a clip
+// that didn't render any frames yet, so we don't know the real cost.
+int EstimateLoadCost(int pixels) {
+	auto frameCost = (pixels > 0 ? pixels : int(AverageGifSize)) / kEstimatedPixelsPerMicrosecond;
+	return frameCost * 1000 / kEstimatedFrameDelayMs;
+}
+
 QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bool hasAlpha, QImage &cache) {
 	auto needResize = (original.width() != request.framew) || (original.height() != request.frameh);
 	auto needOuterFill = (request.outerw != request.framew) || (request.outerh != request.frameh);
@@ -53,6 +84,20 @@ QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bo
 		cache = QImage(request.outerw, request.outerh, QImage::Format_ARGB32_Premultiplied);
 		cache.setDevicePixelRatio(factor);
 	}
+	if (!needResize && !needOuterFill && !hasAlpha && original.depth() == 32) {
+		// Only rounding is required: the frame is opaque, so its ARGB32
+		// pixels are already premultiplied and can be copied as they are.
+		auto bytesPerLine = qMin(original.bytesPerLine(), cache.bytesPerLine());
+		auto from = original.constBits();
+		auto to = cache.bits();
+		for (auto y = 0, height = cache.height(); y != height; ++y) {
+			memcpy(to, from, bytesPerLine);
+			from += original.bytesPerLine();
+			to += cache.bytesPerLine();
+		}
+		Images::prepareRound(cache, request.radius, request.corners);
+		return cache;
+	}
 	{
 		Painter p(&cache);
 		if (needNewCache) {
@@ -103,18 +148,161 @@ Reader::Reader(gsl::not_null<DocumentData*> document, FullMsgId msgId, Callback
 , _mode(mode)
 , _audioMsgId(document, msgId, (mode == Mode::Video) ? rand_value<uint32>() : 0)
 , _seekPositionMs(seekMs) {
+	if (mode == Mode::Gif && !seekMs) {
+		initShared(document);
+		return;
+	}
+
+	// Videos can be played while they're still loading.
+	auto streamed = (mode == Mode::Video && !document->loaded()) ? document->startStreaming() : nullptr;
+	init(document->location(), document->data(), std::move(streamed));
+}
+
+Reader::Reader(gsl::not_null<DocumentData*> document, Callback &&callback)
+: _callback(std::move(callback))
+, _mode(Mode::Gif)
+, _audioMsgId(document, FullMsgId(), 0) {
 	init(document->location(), document->data());
 }
 
-void Reader::init(const FileLocation &location, const QByteArray &data) {
+void Reader::initShared(gsl::not_null<DocumentData*> document) {
+	auto key = document.get();
+	auto i = SharedGifs.find(key);
+	if (i == SharedGifs.end()) {
+		i = SharedGifs.emplace(key, SharedGif()).first;
+		i->second.source.reset(new Reader(document, [key](Notification notification) {
+			// Any of the views can be destroyed by the previous callbacks.
+			auto i = SharedGifs.find(key);
+			if (i == SharedGifs.end()) {
+				return;
+			}
+			auto views = i->second.views;
+			for (auto view : views) {
+				auto j = SharedGifs.find(key);
+				if (j == SharedGifs.end()) {
+					return;
+				}
+				auto &current = j->second.views;
+				if (std::find(current.cbegin(), current.cend(), view) != current.cend() && view->_callback) {
+					view->_callback(notification);
+				}
+			}
+		}));
+	}
+	i->second.views.push_back(this);
+	_source = i->second.source.get();
+}
+
+void Reader::releaseShared() {
+	Expects(_source != nullptr);
+
+	SharedPixCacheSize -= PixmapBytes(_sharedPix);
+	_sharedPix = QPixmap();
+	_sharedPixKey = 0;
+
+	auto i = std::find_if(SharedGifs.begin(), SharedGifs.end(), [this](auto &pair) {
+		return (pair.second.source.get() == _source);
+	});
+	_source = nullptr;
+	if (i == SharedGifs.end()) {
+		return;
+	}
+	auto &views = i->second.views;
+	views.erase(std::remove(views.begin(), views.end(), this), views.end());
+	if (!views.empty()) {
+		// The next frame is prepared in the size needed by the remaining views.
+		i->second.source->updateSharedRequest(views);
+	} else {
+		// We could be inside the source callback right now.
+		base::TaskQueue::Main().Put([source = std::move(i->second.source)]() mutable {
+			source = nullptr;
+		});
+		SharedGifs.erase(i);
+	}
+}
+
+void Reader::updateSharedRequest(const std::vector<Reader*> &views) {
+	// Decode in the largest size among the views in each dimension, so that
+	// none of them has to upscale the frames and the others only downscale.
+	auto result = FrameRequest();
+	for (auto view : views) {
+		auto &request = view->_sharedViewRequest;
+		if (!request.valid()) {
+			continue;
+		} else if (!result.valid()
+			|| (request.framew >= result.framew
+				&& request.frameh >= result.frameh
+				&& request.outerw >= result.outerw
+				&& request.outerh >= result.outerh)) {
+			result = request;
+		} else {
+			accumulate_max(result.framew, request.framew);
+			accumulate_max(result.frameh, request.frameh);
+			accumulate_max(result.outerw, request.outerw);
+			accumulate_max(result.outerh, request.outerh);
+		}
+	}
+	_sharedSourceRequest = result;
+}
+
+QPixmap Reader::currentShared(const FrameRequest &request, TimeMs ms) {
+	auto frame = _source->frameToShow();
+	t_assert(frame != nullptr);
+
+	if (_sharedViewRequest != request) {
+		_sharedViewRequest = request;
+		auto i = SharedGifs.find(_audioMsgId.audio());
+		if (i != SharedGifs.end()) {
+			_source->updateSharedRequest(i->second.views);
+		}
+	}
+	auto sourceRequest = _source->_sharedSourceRequest;
+	Expects(sourceRequest.valid());
+	if (frame->request != sourceRequest) {
+		_source->resizeShownFrame(sourceRequest);
+	}
+
+	// Only the views that are not paused mark the frame as displayed,
+	// so that one paused view doesn't pause the GIF for all the others.
+	auto pix = frame->pix;
+	if (ms) {
+		auto factor = sourceRequest.factor;
+		pix = _source->current(sourceRequest.framew / factor, sourceRequest.frameh / factor, sourceRequest.outerw / factor, sourceRequest.outerh / factor, sourceRequest.radius, sourceRequest.corners, ms);
+	}
+	if (request == sourceRequest) {
+		return pix;
+	} else if (_sharedPixKey == pix.cacheKey() && _sharedRequest == request) {
+		return _sharedPix;
+	}
+
+	QImage cacheForResize;
+	auto original = _source->frameToShow()->original;
+	original.setDevicePixelRatio(request.factor);
+	auto result = PrepareFrame(request, original, true, cacheForResize);
+
+	SharedPixCacheSize -= PixmapBytes(_sharedPix);
+	if (SharedPixCacheSize + PixmapBytes(result) > kSharedPixCacheLimit) {
+		_sharedPix = QPixmap();
+		_sharedPixKey = 0;
+	} else {
+		_sharedPix = result;
+		_sharedPixKey = pix.cacheKey();
+		_sharedRequest = request;
+		SharedPixCacheSize += PixmapBytes(_sharedPix);
+	}
+	return result;
+}
+
+void Reader::init(const FileLocation &location, const QByteArray &data, std::shared_ptr<Storage::StreamedFile> streamed) {
 	if (threads.size() < ClipThreadsCount) {
 		_threadIndex = threads.size();
 		threads.push_back(new QThread());
 		managers.push_back(new Manager(threads.back()));
+		stealTargets[_threadIndex].storeRelease(managers.back());
 		threads.back()->start();
 	} else {
 		_threadIndex = int32(rand_value<uint32>() % threads.size());
-		int32 loadLevel = 0x7FFFFFFF;
+		int32 loadLevel = std::numeric_limits<int32>::max();
 		for (int32 i = 0, l = threads.size(); i < l; ++i) {
 			int32 level = managers.at(i)->loadLevel();
 			if (level < loadLevel) {
@@ -123,7 +311,7 @@ void Reader::init(const FileLocation &location, const QByteArray &data) {
 			}
 		}
 	}
-	managers.at(_threadIndex)->append(this, location, data);
+	managers.at(_threadIndex)->append(this, location, data, std::move(streamed));
 }
 
 Reader::Frame *Reader::frameToShow(int32 *index) const { // 0 means not ready
@@ -203,6 +391,9 @@ void Reader::callback(Reader *reader, int32 threadIndex, Notification notificati
 }
 
 void Reader::start(int32 framew, int32 frameh, int32 outerw, int32 outerh, ImageRoundRadius radius, ImageRoundCorners corners) {
+	if (_source) {
+		return _source->start(framew, frameh, outerw, outerh, radius, corners);
+	}
 	if (managers.size() <= _threadIndex) error();
 	if (_state == State::Error) return;
 
@@ -226,6 +417,19 @@ QPixmap Reader::current(int32 framew, int32 frameh, int32 outerw, int32 outerh,
 	Expects(outerw > 0);
 	Expects(outerh > 0);
 
+	if (_source) {
+		auto factor = cIntRetinaFactor();
+		auto request = FrameRequest();
+		request.factor = factor;
+		request.framew = framew * factor;
+		request.frameh = frameh * factor;
+		request.outerw = outerw * factor;
+		request.outerh = outerh * factor;
+		request.radius = radius;
+		request.corners = corners;
+		return currentShared(request, ms);
+	}
+
 	auto frame = frameToShow();
 	t_assert(frame != nullptr);
 
@@ -256,23 +460,40 @@ QPixmap Reader::current(int32 framew, int32 frameh, int32 outerw, int32 outerh,
 	frame->request.frameh = frameh * factor;
 	frame->request.outerw = outerw * factor;
 	frame->request.outerh = outerh * factor;
+	prepareShownFrame(frame);
+
+	moveToNextShow();
+
+	if (managers.size() <= _threadIndex) error();
+	if (_state != State::Error) {
+		managers.at(_threadIndex)->update(this);
+	}
+
+	return frame->pix;
+}
 
+void Reader::prepareShownFrame(Frame *frame) {
 	QImage cacheForResize;
-	frame->original.setDevicePixelRatio(factor);
+	frame->original.setDevicePixelRatio(frame->request.factor);
 	frame->pix = QPixmap();
 	frame->pix = PrepareFrame(frame->request, frame->original, true, cacheForResize);
 
 	auto other = frameToWriteNext(true);
 	if (other) other->request = frame->request;
+}
 
-	moveToNextShow();
+void Reader::resizeShownFrame(const FrameRequest &request) {
+	auto frame = frameToShow();
+	t_assert(frame != nullptr);
+
+	// Unlike current() this doesn't mark the frame as displayed.
+	frame->request = request;
+	prepareShownFrame(frame);
 
 	if (managers.size() <= _threadIndex) error();
 	if (_state != State::Error) {
 		managers.at(_threadIndex)->update(this);
 	}
-
-	return frame->pix;
 }
 
 QPixmap Reader::current() {
@@ -287,6 +508,9 @@ QPixmap Reader::current() {
 }
 
 bool Reader::ready() const {
+	if (_source) {
+		return _source->ready();
+	}
 	if (_width && _height) return true;
 
 	auto frame = frameToShow();
@@ -299,10 +523,16 @@ bool Reader::ready() const {
 }
 
 bool Reader::hasAudio() const {
+	if (_source) {
+		return _source->hasAudio();
+	}
 	return ready() ? _hasAudio : false;
 }
 
 TimeMs Reader::getPositionMs() const {
+	if (_source) {
+		return _source->getPositionMs();
+	}
 	if (auto frame = frameToShow()) {
 		return frame->positionMs;
 	}
@@ -310,10 +540,16 @@ TimeMs Reader::getPositionMs() const {
 }
 
 TimeMs Reader::getDurationMs() const {
+	if (_source) {
+		return _source->getDurationMs();
+	}
 	return ready() ? _durationMs : 0;
 }
 
 void Reader::pauseResumeVideo() {
+	if (_source) {
+		return _source->pauseResumeVideo();
+	}
 	if (managers.size() <= _threadIndex) error();
 	if (_state == State::Error) return;
 
@@ -322,22 +558,37 @@ void Reader::pauseResumeVideo() {
 }
 
 bool Reader::videoPaused() const {
+	if (_source) {
+		return _source->videoPaused();
+	}
 	return _videoPauseRequest.loadAcquire() != 0;
 }
 
 int32 Reader::width() const {
+	if (_source) {
+		return _source->width();
+	}
 	return _width;
 }
 
 int32 Reader::height() const {
+	if (_source) {
+		return _source->height();
+	}
 	return _height;
 }
 
 State Reader::state() const {
+	if (_source) {
+		return _source->state();
+	}
 	return _state;
 }
 
 void Reader::stop() {
+	if (_source) {
+		return releaseShared();
+	}
 	if (managers.size() <= _threadIndex) error();
 	if (_state != State::Error) {
 		managers.at(_threadIndex)->stop(this);
@@ -361,12 +612,13 @@ Reader::~Reader() {
 
 class ReaderPrivate {
 public:
-	ReaderPrivate(Reader *reader, const FileLocation &location, const QByteArray &data) : _interface(reader)
+	ReaderPrivate(Reader *reader, const FileLocation &location, const QByteArray &data, std::shared_ptr<Storage::StreamedFile> streamed) : _interface(reader)
 	, _mode(reader->mode())
 	, _audioMsgId(reader->audioMsgId())
 	, _seekPositionMs(reader->seekPositionMs())
-	, _data(data) {
-		if (_data.isEmpty()) {
+	, _data(data)
+	, _streamed(std::move(streamed)) {
+		if (_data.isEmpty() && !_streamed) {
 			_location = std::make_unique<FileLocation>(location);
 			if (!_location->accessEnable()) {
 				error();
@@ -388,6 +640,9 @@ public:
 
 				auto firstFramePositionMs = TimeMs(0);
 				auto reader = std::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, AudioMsgId());
+				if (_streamed) {
+					reader->setStreamed(_streamed, _streamInterrupted);
+				}
 				if (reader->start(internal::ReaderImplementation::Mode::Normal, firstFramePositionMs)) {
 					auto firstFrameReadResult = reader->readFramesTill(-1, ms);
 					if (firstFrameReadResult == internal::ReaderImplementation::ReadResult::Success) {
@@ -447,6 +702,10 @@ public:
 	}
 
 	ProcessResult finishProcess(TimeMs ms) {
+		QElapsedTimer costTimer;
+		costTimer.start();
+		auto previousFrameWhen = _nextFrameWhen;
+
 		auto frameMs = _seekPositionMs + ms - _animationStarted;
 		auto readResult = _implementation->readFramesTill(frameMs, ms);
 		if (readResult == internal::ReaderImplementation::ReadResult::EndOfFile) {
@@ -467,9 +726,30 @@ public:
 		if (!renderFrame()) {
 			return error();
 		}
+		countFrameCost(costTimer.nsecsElapsed() / 1000, _nextFrameWhen - previousFrameWhen);
 		return ProcessResult::CopyFrame;
 	}
 
+	void countFrameCost(int64 costUs, TimeMs delayMs) {
+		auto average = [](int64 was, int64 now) {
+			return was ? ((was * (kLoadCostAveraging - 1) + now) / kLoadCostAveraging) : now;
+		};
+		_frameCostUs = average(_frameCostUs, qMax(costUs, 1LL));
+		if (delayMs > 0) {
+			_frameDelayMs = average(_frameDelayMs, delayMs);
+		}
+	}
+
+	// Decoding work in microseconds per second of playback.
+	int loadCost() const {
+		if (_autoPausedGif || _videoPausedAtMs) {
+			return 0;
+		} else if (!_frameCostUs || !_frameDelayMs) {
+			return EstimateLoadCost(_width * _height);
+		}
+		return int(qMin(_frameCostUs * 1000 / _frameDelayMs, int64(std::numeric_limits<int>::max() / ClipThreadsCount)));
+	}
+
 	bool renderFrame() {
 		t_assert(frame() != 0 && _request.valid());
 		if (!_implementation->renderFrame(frame()->original, frame()->alpha, QSize(_request.framew, _request.frameh))) {
@@ -484,7 +764,7 @@ public:
 	}
 
 	bool init() {
-		if (_data.isEmpty() && QFileInfo(_location->name()).size() <= AnimationInMemory) {
+		if (_data.isEmpty() && _location && QFileInfo(_location->name()).size() <= AnimationInMemory) {
 			QFile f(_location->name());
 			if (f.open(QIODevice::ReadOnly)) {
 				_data = f.readAll();
@@ -496,6 +776,9 @@ public:
 
 		_implementation = std::make_unique<internal::FFMpegReaderImplementation>(_location.get(), &_data, _audioMsgId);
 //		_implementation = new QtGifReaderImplementation(_location, &_data);
+		if (_streamed) {
+			_implementation->setStreamed(_streamed, _streamInterrupted);
+		}
 
 		auto implementationMode = [this]() {
 			using ImplementationMode = internal::ReaderImplementation::Mode;
@@ -533,6 +816,14 @@ public:
 		}
 	}
 
+	// Called from the main thread to stop waiting for the streamed parts.
+	void interrupt() {
+		_streamInterrupted.storeRelease(1);
+		if (_streamed) {
+			_streamed->wakeReaders();
+		}
+	}
+
 	ProcessResult error() {
 		stop(Player::State::StoppedAtError);
 		_state = State::Error;
@@ -570,6 +861,9 @@ private:
 	std::unique_ptr<FileLocation> _location;
 	bool _accessed = false;
 
+	std::shared_ptr<Storage::StreamedFile> _streamed;
+	QAtomicInt _streamInterrupted = 0;
+
 	QBuffer _buffer;
 	std::unique_ptr<internal::ReaderImplementation> _implementation;
 
@@ -602,6 +896,10 @@ private:
 	bool _started = false;
 	TimeMs _videoPausedAtMs = 0;
 
+	int64 _frameCostUs = 0;
+	int64 _frameDelayMs = 0;
+	int _loadCost = 0; // Accounted in the Manager::_loadLevel.
+
 	friend class Manager;
 
 };
@@ -619,9 +917,9 @@ Manager::Manager(QThread *thread) : _processingInThread(0), _needReProcess(false
 	anim::registerClipManager(this);
 }
 
-void Manager::append(Reader *reader, const FileLocation &location, const QByteArray &data) {
-	reader->_private = new ReaderPrivate(reader, location, data);
-	_loadLevel.fetchAndAddRelaxed(AverageGifSize);
+void Manager::append(Reader *reader, const FileLocation &location, const QByteArray &data, std::shared_ptr<Storage::StreamedFile> streamed) {
+	reader->_private = new ReaderPrivate(reader, location, data, std::move(streamed));
+	updateLoad(reader->_private);
 	update(reader);
 }
 
@@ -644,6 +942,10 @@ void Manager::stop(Reader *reader) {
 	if (!carries(reader)) return;
 
 	QMutexLocker lock(&_readerPointersMutex);
+	if (_readerPointers.contains(reader) && reader->_private) {
+		// The clip thread may be blocked waiting for a streamed part.
+		reader->_private->interrupt();
+	}
 	_readerPointers.remove(reader);
 	emit processDelayed();
 }
@@ -689,7 +991,6 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, T
 	}
 
 	if (result == ProcessResult::Started) {
-		_loadLevel.fetchAndAddRelaxed(reader->_width * reader->_height - AverageGifSize);
 		it.key()->_durationMs = reader->_durationMs;
 		it.key()->_hasAudio = reader->_hasAudio;
 	}
@@ -731,13 +1032,14 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, T
 
 Manager::ResultHandleState Manager::handleResult(ReaderPrivate *reader, ProcessResult result, TimeMs ms) {
 	if (!handleProcessResult(reader, result, ms)) {
-		_loadLevel.fetchAndAddRelaxed(-1 * (reader->_width > 0 ? reader->_width * reader->_height : AverageGifSize));
-		delete reader;
+		removeReader(reader);
 		return ResultHandleRemove;
 	}
 
-	_processingInThread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
-	if (_processingInThread->isInterruptionRequested()) {
+	// The reader could be stolen, so we process events of the current thread.
+	auto thread = QThread::currentThread();
+	thread->eventDispatcher()->processEvents(QEventLoop::AllEvents);
+	if (thread->isInterruptionRequested()) {
 		return ResultHandleStop;
 	}
 
@@ -763,33 +1065,63 @@ Manager::ResultHandleState Manager::handleResult(ReaderPrivate *reader, ProcessR
 	return ResultHandleContinue;
 }
 
-void Manager::process() {
-	if (_processingInThread) {
-		_needReProcess = true;
-		return;
+Manager::ResultHandleState Manager::processReader(ReaderPrivate *reader, TimeMs ms) {
+	auto state = handleResult(reader, reader->process(ms), ms);
+	if (state == ResultHandleRemove) {
+		return state;
 	}
+	ms = getms();
+	auto when = ms + 86400 * 1000LL;
+	if (!reader->_videoPausedAtMs && reader->_nextFrameWhen && reader->_started) {
+		when = reader->_nextFrameWhen;
+	}
+	updateLoad(reader);
+
+	QMutexLocker lock(&_readersMutex);
+	auto i = _readers.find(reader);
+	t_assert(i != _readers.cend());
+	i->second.when = when;
+	i->second.processing = false;
+	return state;
+}
 
-	_timer.stop();
-	_processingInThread = thread();
+void Manager::updateLoad(ReaderPrivate *reader) {
+	auto cost = reader->loadCost();
+	_loadLevel.fetchAndAddRelaxed(cost - reader->_loadCost);
+	reader->_loadCost = cost;
+}
 
-	bool checkAllReaders = false;
-	auto ms = getms(), minms = ms + 86400 * 1000LL;
+void Manager::removeReader(ReaderPrivate *reader) {
 	{
-		QMutexLocker lock(&_readerPointersMutex);
+		QMutexLocker lock(&_readersMutex);
+		_readers.erase(reader);
+	}
+	_loadLevel.fetchAndAddRelaxed(-reader->_loadCost);
+	delete reader;
+}
+
+void Manager::syncReaders(TimeMs ms) {
+	auto removed = std::vector<ReaderPrivate*>();
+	{
+		QMutexLocker pointersLock(&_readerPointersMutex);
+		QMutexLocker readersLock(&_readersMutex);
 		for (auto it = _readerPointers.begin(), e = _readerPointers.end(); it != e; ++it) {
 			if (it->loadAcquire() && it.key()->_private != nullptr) {
 				auto i = _readers.find(it.key()->_private);
 				if (i == _readers.cend()) {
-					_readers.insert(it.key()->_private, 0);
+					_readers.emplace(it.key()->_private, ReaderState());
+				} else if (i->second.processing) {
+					// Stolen by another thread, keep the update flag for the next time.
+					continue;
 				} else {
-					i.value() = ms;
-					if (i.key()->_autoPausedGif && !it.key()->_autoPausedGif.loadAcquire()) {
-						i.key()->_autoPausedGif = false;
+					i->second.when = ms;
+					if (i->first->_autoPausedGif && !it.key()->_autoPausedGif.loadAcquire()) {
+						i->first->_autoPausedGif = false;
 					}
 					if (it.key()->_videoPauseRequest.loadAcquire()) {
-						i.key()->pauseVideo(ms);
+						i->first->pauseVideo(ms);
 					} else {
-						i.key()->resumeVideo(ms);
+						i->first->resumeVideo(ms);
 					}
 				}
 				auto frame = it.key()->frameToWrite();
@@ -797,42 +1129,137 @@ void Manager::process() {
 				it->storeRelease(0);
 			}
 		}
-		checkAllReaders = (_readers.size() > _readerPointers.size());
+		if (_readers.size() > _readerPointers.size()) {
+			for (auto i = _readers.begin(); i != _readers.end();) {
+				if (!i->second.processing && constUnsafeFindReaderPointer(i->first) == _readerPointers.cend()) {
+					removed.push_back(i->first);
+					i = _readers.erase(i);
+				} else {
+					++i;
+				}
+			}
+		}
 	}
+	for (auto reader : removed) {
+		_loadLevel.fetchAndAddRelaxed(-reader->_loadCost);
+		delete reader;
+	}
+}
 
-	for (auto i = _readers.begin(), e = _readers.end(); i != e;) {
-		ReaderPrivate *reader = i.key();
-		if (i.value() <= ms) {
-			ResultHandleState state = handleResult(reader, reader->process(ms), ms);
-			if (state == ResultHandleRemove) {
-				i = _readers.erase(i);
-				continue;
-			} else if (state == ResultHandleStop) {
-				_processingInThread = 0;
-				return;
+std::vector<ReaderPrivate*> Manager::takeDueReaders(TimeMs ms) {
+	auto result = std::vector<std::pair<TimeMs, ReaderPrivate*>>();
+	{
+		QMutexLocker lock(&_readersMutex);
+		for (auto &reader : _readers) {
+			if (!reader.second.processing && reader.second.when <= ms) {
+				reader.second.processing = true;
+				result.push_back(std::make_pair(reader.second.when, reader.first));
 			}
-			ms = getms();
-			if (reader->_videoPausedAtMs) {
-				i.value() = ms + 86400 * 1000ULL;
-			} else if (reader->_nextFrameWhen && reader->_started) {
-				i.value() = reader->_nextFrameWhen;
-			} else {
-				i.value() = (ms + 86400 * 1000ULL);
+		}
+	}
+
+	// The most late frames are processed first.
+	std::sort(result.begin(), result.end());
+	auto readers = std::vector<ReaderPrivate*>();
+	readers.reserve(result.size());
+	for (auto &reader : result) {
+		readers.push_back(reader.second);
+	}
+	return readers;
+}
+
+ReaderPrivate *Manager::stealDueReader(TimeMs ms) {
+	if (!_busy.loadAcquire()) {
+		return nullptr;
+	}
+	QMutexLocker lock(&_readersMutex);
+	auto result = _readers.end();
+	for (auto i = _readers.begin(), e = _readers.end(); i != e; ++i) {
+		if (!i->second.processing && !i->first->_autoPausedGif && i->second.when <= ms) {
+			if (result == e || i->second.when < result->second.when) {
+				result = i;
 			}
-		} else if (checkAllReaders) {
-			QMutexLocker lock(&_readerPointersMutex);
-			auto it = constUnsafeFindReaderPointer(reader);
-			if (it == _readerPointers.cend()) {
-				_loadLevel.fetchAndAddRelaxed(-1 * (reader->_width > 0 ? reader->_width * reader->_height : AverageGifSize));
-				delete reader;
-				i = _readers.erase(i);
-				continue;
+		}
+	}
+	if (result == _readers.end()) {
+		return nullptr;
+	}
+	result->second.processing = true;
+	return result->first;
+}
+
+bool Manager::stealAndProcess() {
+	auto thread = QThread::currentThread();
+	if (thread->isInterruptionRequested()) {
+		return false;
+	}
+
+	// Take the most late frame from a manager which is busy with others.
+	auto ms = getms();
+	auto victim = (Manager*)nullptr;
+	auto reader = (ReaderPrivate*)nullptr;
+	for (auto &target : stealTargets) {
+		auto manager = target.loadAcquire();
+		if (manager && manager != this) {
+			if ((reader = manager->stealDueReader(ms))) {
+				victim = manager;
+				break;
 			}
 		}
-		if (!reader->_autoPausedGif && i.value() < minms) {
-			minms = i.value();
+	}
+	if (!reader) {
+		return false;
+	}
+	if (victim->processReader(reader, ms) == ResultHandleStop) {
+		return false;
+	}
+
+	// Let the owner reschedule its timer with the new frame time.
+	emit victim->processDelayed();
+	return true;
+}
+
+void Manager::process() {
+	if (_processingInThread) {
+		_needReProcess = true;
+		return;
+	}
+
+	_timer.stop();
+	_processingInThread = thread();
+	_busy.storeRelease(1);
+
+	auto ms = getms();
+	syncReaders(ms);
+
+	auto readers = takeDueReaders(ms);
+	for (auto i = readers.begin(), e = readers.end(); i != e; ++i) {
+		if (processReader(*i, ms) == ResultHandleStop) {
+			// Return the readers we didn't process to make clear() possible.
+			QMutexLocker lock(&_readersMutex);
+			for (auto j = i + 1; j != e; ++j) {
+				_readers[*j].processing = false;
+			}
+			_busy.storeRelease(0);
+			_processingInThread = 0;
+			return;
+		}
+		ms = getms();
+	}
+	_busy.storeRelease(0);
+
+	auto minms = getms() + 86400 * 1000LL;
+	{
+		QMutexLocker lock(&_readersMutex);
+		for (auto &reader : _readers) {
+			if (!reader.second.processing && !reader.first->_autoPausedGif && reader.second.when < minms) {
+				minms = reader.second.when;
+			}
 		}
-		++i;
+	}
+
+	// Help other threads with their late frames until our next frame.
+	while (!_needReProcess && getms() < minms && stealAndProcess()) {
 	}
 
 	ms = getms();
@@ -860,10 +1287,24 @@ void Manager::clear() {
 		_readerPointers.clear();
 	}
 
-	for (Readers::iterator i = _readers.begin(), e = _readers.end(); i != e; ++i) {
-		delete i.key();
+	// Wait for the readers that are processed by other threads right now.
+	auto readers = Readers();
+	while (true) {
+		{
+			QMutexLocker lock(&_readersMutex);
+			auto processing = std::any_of(_readers.cbegin(), _readers.cend(), [](auto &reader) {
+				return reader.second.processing;
+			});
+			if (!processing) {
+				readers = base::take(_readers);
+				break;
+			}
+		}
+		QThread::msleep(1);
+	}
+	for (auto &reader : readers) {
+		delete reader.first;
 	}
-	_readers.clear();
 }
 
 Manager::~Manager() {
@@ -908,10 +1349,17 @@ FileLoadTask::Video PrepareForSending(const QString &fname, const QByteArray &da
 
 void Finish() {
 	if (!threads.isEmpty()) {
+		// All the threads should stop stealing before any of them is cleared.
+		for (auto thread : threads) {
+			thread->requestInterruption();
+		}
 		for (int32 i = 0, l = threads.size(); i < l; ++i) {
 			threads.at(i)->quit();
 			DEBUG_LOG(("Waiting for clipThread to finish: %1").arg(i));
 			threads.at(i)->wait();
+		}
+		for (int32 i = 0, l = threads.size(); i < l; ++i) {
+			stealTargets[i].storeRelease(nullptr);
 			delete managers.at(i);
 			delete threads.at(i);
 		}
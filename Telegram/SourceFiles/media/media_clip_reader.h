@@ -24,6 +24,10 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 class FileLocation;
 
+namespace Storage {
+class StreamedFile;
+} // namespace Storage
+
 namespace Media {
 namespace Clip {
 
@@ -37,6 +41,18 @@ struct FrameRequest {
 	bool valid() const {
 		return factor > 0;
 	}
+	bool operator==(const FrameRequest &other) const {
+		return (factor == other.factor)
+			&& (framew == other.framew)
+			&& (frameh == other.frameh)
+			&& (outerw == other.outerw)
+			&& (outerh == other.outerh)
+			&& (radius == other.radius)
+			&& (corners == other.corners);
+	}
+	bool operator!=(const FrameRequest &other) const {
+		return !(*this == other);
+	}
 	int factor = 0;
 	int framew = 0;
 	int frameh = 0;
@@ -84,6 +100,9 @@ public:
 	QPixmap current(int framew, int frameh, int outerw, int outerh, ImageRoundRadius radius, ImageRoundCorners corners, TimeMs ms);
 	QPixmap current();
 	QPixmap frameOriginal() const {
+		if (_source) {
+			return _source->frameOriginal();
+		}
 		if (auto frame = frameToShow()) {
 			auto result = QPixmap::fromImage(frame->original);
 			result.detach();
@@ -92,15 +111,18 @@ public:
 		return QPixmap();
 	}
 	bool currentDisplayed() const {
+		if (_source) {
+			return _source->currentDisplayed();
+		}
 		auto frame = frameToShow();
 		return frame ? (frame->displayed.loadAcquire() != 0) : true;
 	}
 	bool autoPausedGif() const {
-		return _autoPausedGif.loadAcquire();
+		return _source ? _source->autoPausedGif() : (_autoPausedGif.loadAcquire() != 0);
 	}
 	bool videoPaused() const;
 	int threadIndex() const {
-		return _threadIndex;
+		return _source ? _source->threadIndex() : _threadIndex;
 	}
 
 	int width() const;
@@ -108,6 +130,9 @@ public:
 
 	State state() const;
 	bool started() const {
+		if (_source) {
+			return _source->started();
+		}
 		auto step = _step.loadAcquire();
 		return (step == WaitingForFirstFrameStep) || (step >= 0);
 	}
@@ -129,7 +154,14 @@ public:
 	~Reader();
 
 private:
-	void init(const FileLocation &location, const QByteArray &data);
+	// Decoding reader for a shared animated document.
+	Reader(gsl::not_null<DocumentData*> document, Callback &&callback);
+
+	void init(const FileLocation &location, const QByteArray &data, std::shared_ptr<Storage::StreamedFile> streamed = nullptr);
+	void initShared(gsl::not_null<DocumentData*> document);
+	QPixmap currentShared(const FrameRequest &request, TimeMs ms);
+	void releaseShared();
+	void updateSharedRequest(const std::vector<Reader*> &views);
 
 	Callback _callback;
 	Mode _mode;
@@ -166,13 +198,26 @@ private:
 	Frame *frameToWriteNext(bool check, int *index = nullptr) const;
 	void moveToNextShow() const;
 	void moveToNextWrite() const;
+	void prepareShownFrame(Frame *frame);
+	void resizeShownFrame(const FrameRequest &request);
 
 	QAtomicInt _autoPausedGif = 0;
 	QAtomicInt _videoPauseRequest = 0;
-	int32 _threadIndex;
+	int32 _threadIndex = 0;
 
 	bool _autoplay = false;
 
+	// Several readers of the same GIF show the frames of one decoding
+	// reader, preparing their own copy only if their size is different.
+	Reader *_source = nullptr;
+	QPixmap _sharedPix;
+	FrameRequest _sharedRequest;
+	qint64 _sharedPixKey = 0;
+	FrameRequest _sharedViewRequest;
+
+	// For the decoding reader: the size in which the views need the frames.
+	FrameRequest _sharedSourceRequest;
+
 	friend class Manager;
 
 	ReaderPrivate *_private = nullptr;
@@ -200,10 +245,12 @@ class Manager : public QObject {
 public:
 
 	Manager(QThread *thread);
+
+	// Sum of the readers decoding cost estimates in microseconds per second.
 	int32 loadLevel() const {
 		return _loadLevel.load();
 	}
-	void append(Reader *reader, const FileLocation &location, const QByteArray &data);
+	void append(Reader *reader, const FileLocation &location, const QByteArray &data, std::shared_ptr<Storage::StreamedFile> streamed);
 	void start(Reader *reader);
 	void update(Reader *reader);
 	void stop(Reader *reader);
@@ -239,9 +286,25 @@ private:
 		ResultHandleContinue,
 	};
 	ResultHandleState handleResult(ReaderPrivate *reader, ProcessResult result, TimeMs ms);
-
-	typedef QMap<ReaderPrivate*, TimeMs> Readers;
+	ResultHandleState processReader(ReaderPrivate *reader, TimeMs ms);
+	void updateLoad(ReaderPrivate *reader);
+	void removeReader(ReaderPrivate *reader);
+	void syncReaders(TimeMs ms);
+	std::vector<ReaderPrivate*> takeDueReaders(TimeMs ms);
+
+	// Work stealing: when a thread has no due frames of its own it takes
+	// the most late frame of a reader from a manager busy with others.
+	bool stealAndProcess();
+	ReaderPrivate *stealDueReader(TimeMs ms);
+
+	struct ReaderState {
+		TimeMs when = 0;
+		bool processing = false; // By this or by some other clip thread.
+	};
+	using Readers = std::map<ReaderPrivate*, ReaderState>;
 	Readers _readers;
+	mutable QMutex _readersMutex;
+	QAtomicInt _busy = 0;
 
 	QTimer _timer;
 	QThread *_processingInThread;
@@ -33,6 +33,9 @@ namespace {
 
 Instance *SingleInstance = nullptr;
 
+// Decode the beginning of the next track when this much is left to play.
+constexpr auto kPrepareNextBeforeEndMs = 5000LL;
+
 } // namespace
 
 void start() {
@@ -125,6 +128,10 @@ void Instance::setCurrent(const AudioMsgId &audioId) {
 		if (data->current != audioId) {
 			data->current = audioId;
 			data->isPlaying = false;
+			if (data->prepared != audioId) {
+				mixer()->unprepare(data->type);
+			}
+			data->prepared = AudioMsgId();
 
 			auto history = data->history;
 			auto migrated = data->migrated;
@@ -242,6 +249,10 @@ void Instance::stop(AudioMsgId::Type type) {
 	if (state.id) {
 		mixer()->stop(state.id);
 	}
+	if (auto data = getData(type)) {
+		data->prepared = AudioMsgId();
+	}
+	mixer()->unprepare(type);
 }
 
 void Instance::playPause(AudioMsgId::Type type) {
@@ -339,24 +350,55 @@ void Instance::emitUpdate(AudioMsgId::Type type, CheckCallback check) {
 				preloadNext(data);
 			}
 		}
+		if (data->isPlaying && state.frequency > 0) {
+			auto leftMs = (state.length - state.position) * 1000LL / state.frequency;
+			if (leftMs < kPrepareNextBeforeEndMs) {
+				prepareNext(data);
+			}
+		}
 	}
 }
 
-void Instance::preloadNext(Data *data) {
+HistoryItem *Instance::nextItem(Data *data) const {
 	Expects(data != nullptr);
 
 	if (!data->current) {
-		return;
+		return nullptr;
 	}
 	auto index = data->playlist.indexOf(data->current.contextId());
 	if (index < 0) {
-		return;
+		return nullptr;
 	}
 	auto nextIndex = index + 1;
 	if (nextIndex >= data->playlist.size()) {
+		return nullptr;
+	}
+	return App::histItemById(data->playlist[nextIndex]);
+}
+
+void Instance::prepareNext(Data *data) {
+	Expects(data != nullptr);
+
+	if (data->repeatEnabled) {
 		return;
 	}
-	if (auto item = App::histItemById(data->playlist[nextIndex])) {
+	if (auto item = nextItem(data)) {
+		if (auto media = item->getMedia()) {
+			if (auto document = media->getDocument()) {
+				auto audio = AudioMsgId(document, item->fullId());
+				if (data->prepared != audio && document->loaded(DocumentData::FilePathResolveSaveFromDataSilent)) {
+					data->prepared = audio;
+					mixer()->prepare(audio);
+				}
+			}
+		}
+	}
+}
+
+void Instance::preloadNext(Data *data) {
+	Expects(data != nullptr);
+
+	if (auto item = nextItem(data)) {
 		if (auto media = item->getMedia()) {
 			if (auto document = media->getDocument()) {
 				if (!document->loaded(DocumentData::FilePathResolveSaveFromDataSilent)) {
@@ -24,6 +24,7 @@ namespace Notify {
 struct PeerUpdate;
 } // namespace Notify
 class AudioMsgId;
+class HistoryItem;
 
 namespace Media {
 namespace Player {
@@ -159,6 +160,7 @@ private:
 		bool repeatEnabled = false;
 		QList<FullMsgId> playlist;
 		bool isPlaying = false;
+		AudioMsgId prepared;
 	};
 
 	// Observed notifications.
@@ -170,6 +172,8 @@ private:
 	void rebuildPlaylist(Data *data);
 	bool moveInPlaylist(Data *data, int delta, bool autonext);
 	void preloadNext(Data *data);
+	void prepareNext(Data *data);
+	HistoryItem *nextItem(Data *data) const;
 	void handleLogout();
 
 	template <typename CheckCallback>
@@ -46,6 +46,9 @@ constexpr auto kMaxModExpSize = 256;
 // Don't try to handle messages larger than this size.
 constexpr auto kMaxMessageLength = 16 * 1024 * 1024;
 
+// Traffic counters are summarized in the debug log this often.
+constexpr auto kTrafficStatsTimeout = 60 * TimeMs(1000);
+
 bool IsGoodModExpFirst(const openssl::BigNum &modexp, const openssl::BigNum &prime) {
 	auto diff = prime - modexp;
 	if (modexp.failed() || prime.failed() || diff.failed()) {
@@ -152,7 +155,23 @@ bool IsPrimeAndGood(base::const_byte_span primeBytes, int g) {
 		}
 	}
 
-	return IsPrimeAndGoodCheck(openssl::BigNum(primeBytes), g);
+	// Servers keep sending the same few primes, so remember the ones
+	// that were already checked instead of testing them on each key.
+	static QMutex VerifiedMutex;
+	static std::set<std::pair<QByteArray, int>> Verified;
+	auto key = std::make_pair(QByteArray(reinterpret_cast<const char*>(primeBytes.data()), primeBytes.size()), g);
+	{
+		QMutexLocker lock(&VerifiedMutex);
+		if (Verified.find(key) != Verified.cend()) {
+			return true;
+		}
+	}
+	if (!IsPrimeAndGoodCheck(openssl::BigNum(primeBytes), g)) {
+		return false;
+	}
+	QMutexLocker lock(&VerifiedMutex);
+	Verified.insert(std::move(key));
+	return true;
 }
 
 std::vector<gsl::byte> CreateAuthKey(base::const_byte_span firstBytes, base::const_byte_span randomBytes, base::const_byte_span primeBytes) {
@@ -211,6 +230,81 @@ void wrapInvokeAfter(mtpRequest &to, const mtpRequest &from, const mtpRequestMap
 	}
 }
 
+uint64 AddModulo(uint64 a, uint64 b, uint64 modulo) {
+	return (a >= modulo - b) ? (a - (modulo - b)) : (a + b);
+}
+
+// a * b % modulo for a, b < modulo.
+uint64 MultiplyModulo(uint64 a, uint64 b, uint64 modulo) {
+#ifdef __SIZEOF_INT128__
+	return uint64((unsigned __int128)a * b % modulo);
+#else // __SIZEOF_INT128__
+	// Portable version for compilers without 128 bit integers.
+	auto result = uint64(0);
+	while (b) {
+		if (b & 1) {
+			result = AddModulo(result, a, modulo);
+		}
+		a = AddModulo(a, a, modulo);
+		b >>= 1;
+	}
+	return result;
+#endif // __SIZEOF_INT128__
+}
+
+uint64 GreatestCommonDivisor(uint64 a, uint64 b) {
+	while (b) {
+		a %= b;
+		std::swap(a, b);
+	}
+	return a;
+}
+
+// Pollard's rho with Brent's cycle detection, gcd is taken once per batch.
+// Takes O(pq^(1/4)) steps regardless of how far apart p and q are.
+uint64 FindFactor(uint64 pq) {
+	if (!(pq & 1)) {
+		return 2;
+	}
+	constexpr auto kBatchSize = uint64(128);
+	constexpr auto kMaxAttempts = uint64(32);
+	for (auto c = uint64(1); c != kMaxAttempts; ++c) {
+		auto next = [pq, c](uint64 value) {
+			return AddModulo(MultiplyModulo(value, value, pq), c, pq);
+		};
+		auto distance = [](uint64 a, uint64 b) {
+			return (a > b) ? (a - b) : (b - a);
+		};
+		auto y = uint64(2), x = y, saved = y;
+		auto product = uint64(1), divisor = uint64(1);
+		for (auto range = uint64(1); divisor == 1; range <<= 1) {
+			x = y;
+			for (auto i = uint64(0); i != range; ++i) {
+				y = next(y);
+			}
+			for (auto k = uint64(0); k < range && divisor == 1; k += kBatchSize) {
+				saved = y;
+				for (auto i = uint64(0), till = qMin(kBatchSize, range - k); i != till; ++i) {
+					y = next(y);
+					product = MultiplyModulo(product, distance(x, y), pq);
+				}
+				divisor = GreatestCommonDivisor(product, pq);
+			}
+		}
+		if (divisor == pq) {
+			// The whole batch collapsed, redo it step by step.
+			do {
+				saved = next(saved);
+				divisor = GreatestCommonDivisor(distance(x, saved), pq);
+			} while (divisor == 1);
+		}
+		if (divisor != pq) {
+			return divisor;
+		}
+	}
+	return 0;
+}
+
 bool parsePQ(const QByteArray &pqStr, QByteArray &pStr, QByteArray &qStr) {
 	if (pqStr.length() > 8) return false; // more than 64 bit pq
 
@@ -220,21 +314,13 @@ bool parsePQ(const QByteArray &pqStr, QByteArray &pStr, QByteArray &qStr) {
 		pq <<= 8;
 		pq |= (uint64)pqChars[i];
 	}
-	uint64 pqSqrt = (uint64)sqrtl((long double)pq), ySqr, y;
-	while (pqSqrt * pqSqrt > pq) --pqSqrt;
-	while (pqSqrt * pqSqrt < pq) ++pqSqrt;
-	for (ySqr = pqSqrt * pqSqrt - pq; ; ++pqSqrt, ySqr = pqSqrt * pqSqrt - pq) {
-		y = (uint64)sqrtl((long double)ySqr);
-		while (y * y > ySqr) --y;
-		while (y * y < ySqr) ++y;
-		if (!ySqr || y + pqSqrt >= pq) return false;
-		if (y * y == ySqr) {
-			p = pqSqrt + y;
-			q = (pqSqrt > y) ? (pqSqrt - y) : (y - pqSqrt);
-			break;
-		}
-	}
+	if (pq < 4) return false;
+
+	p = FindFactor(pq);
+	if (!p || p == 1 || p == pq) return false;
+	q = pq / p;
 	if (p > q) std::swap(p, q);
+	if (q > 0xFFFFFFFFULL) return false; // p and q are sent as 32 bit
 
 	pStr.resize(4);
 	uchar *pChars = (uchar*)pStr.data();
@@ -1119,6 +1205,9 @@ void ConnectionPrivate::onSentSome(uint64 size) {
 		_waitForReceivedTimer.start(remain);
 	}
 	if (!firstSentAt) firstSentAt = getms(true);
+
+	_trafficStats.sentBytes += size;
+	++_trafficStats.sentPackets;
 }
 
 void ConnectionPrivate::onReceivedSome() {
@@ -1135,6 +1224,48 @@ void ConnectionPrivate::onReceivedSome() {
 		if (ms > 0 && ms * 2 < int32(_waitForReceived)) _waitForReceived = qMax(ms * 2, int32(MTPMinReceiveDelay));
 		firstSentAt = -1;
 	}
+	checkTrafficStats();
+}
+
+void ConnectionPrivate::checkTrafficStats() {
+	auto ms = getms(true);
+	if (!_trafficStats.startedAt) {
+		_trafficStats.startedAt = ms;
+		return;
+	}
+	auto duration = ms - _trafficStats.startedAt;
+	if (duration < kTrafficStatsTimeout) {
+		return;
+	}
+	auto stats = base::take(_trafficStats);
+	_trafficStats.startedAt = ms;
+	if (!cDebug()) {
+		return;
+	}
+
+	auto &latencies = stats.latencies;
+	auto percentile = [&latencies](int percent) {
+		if (latencies.empty()) {
+			return TimeMs(0);
+		}
+		auto nth = latencies.begin() + (latencies.size() - 1) * percent / 100;
+		std::nth_element(latencies.begin(), nth, latencies.end());
+		return *nth;
+	};
+	auto perSecond = [duration](int64 value) {
+		return value * 1000 / duration;
+	};
+	DEBUG_LOG(("MTP Info: traffic for dc %1 in %2ms, sent %3 packets, %4 bytes/s, received %5 packets, %6 bytes/s, %7 responses, latency p50 %8ms, p90 %9ms, p99 %10ms"
+		).arg(_shiftedDcId
+		).arg(duration
+		).arg(stats.sentPackets
+		).arg(perSecond(stats.sentBytes)
+		).arg(stats.receivedPackets
+		).arg(perSecond(stats.receivedBytes)
+		).arg(int(latencies.size())
+		).arg(percentile(50)
+		).arg(percentile(90)
+		).arg(percentile(99)));
 }
 
 void ConnectionPrivate::onOldConnection() {
@@ -1268,6 +1399,8 @@ void ConnectionPrivate::handleReceived() {
 		constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
 		constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
 		auto intsCount = uint32(intsBuffer.size());
+		_trafficStats.receivedBytes += intsCount * kIntSize;
+		++_trafficStats.receivedPackets;
 		auto ints = intsBuffer.constData();
 		if ((intsCount < kMinimalIntsCount) || (intsCount > kMaxMessageLength / kIntSize)) {
 			LOG(("TCP Error: bad message received, len %1").arg(intsCount * kIntSize));
@@ -2112,6 +2245,9 @@ void ConnectionPrivate::requestsAcked(const QVector<MTPlong> &ids, bool byRespon
 							moveToAcked = !_instance->hasCallbacks(reqId);
 						}
 						if (moveToAcked) {
+							if (byResponse) {
+								_trafficStats.latencies.push_back(getms(true) - req.value()->msDate);
+							}
 							wereAcked.insert(msgId, reqId);
 							haveSent.erase(req);
 						} else {
@@ -2403,11 +2539,13 @@ void ConnectionPrivate::pqAnswered() {
 	auto &pq = res_pq_data.vpq.v;
 	auto p = QByteArray();
 	auto q = QByteArray();
+	auto factorizeStart = getms(true);
 	if (!MTP::internal::parsePQ(pq, p, q)) {
 		LOG(("AuthKey Error: could not factor pq!"));
 		DEBUG_LOG(("AuthKey Error: problematic pq: %1").arg(Logs::mb(pq.constData(), pq.length()).str()));
 		return restart();
 	}
+	DEBUG_LOG(("AuthKey Info: pq factored in %1 ms").arg(getms(true) - factorizeStart));
 
 	auto p_q_inner = MTP_p_q_inner_data(res_pq_data.vpq, MTP_bytes(std::move(p)), MTP_bytes(std::move(q)), _authKeyData->nonce, _authKeyData->server_nonce, _authKeyData->new_nonce);
 	auto dhEncString = encryptPQInnerRSA(p_q_inner, rsaKey);
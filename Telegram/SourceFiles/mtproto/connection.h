@@ -222,6 +222,18 @@ private:
 	uint32 _waitForReceived, _waitForConnected;
 	TimeMs firstSentAt = -1;
 
+	// Traffic and response latency counters, written to the debug log.
+	struct TrafficStats {
+		TimeMs startedAt = 0;
+		int64 sentBytes = 0;
+		int64 receivedBytes = 0;
+		int sentPackets = 0;
+		int receivedPackets = 0;
+		std::vector<TimeMs> latencies;
+	};
+	TrafficStats _trafficStats;
+	void checkTrafficStats();
+
 	QVector<MTPlong> ackRequestData, resendRequestData;
 
 	// if badTime received - search for ids in sessionData->haveSent and sessionData->wereAcked and sync time/salt, return true if found
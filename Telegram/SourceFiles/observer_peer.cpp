@@ -45,9 +45,39 @@ void FinishCallback() {
 }
 
 base::Observable<PeerUpdate, PeerUpdatedHandler> PeerUpdatedObservable;
+std::map<PeerData*, base::Observable<PeerUpdate, PeerUpdatedHandler>> PeerUpdatedByPeerObservables;
+
+// Handlers called while the delayed peer updates were sent.
+int PeerUpdatedHandlersCalled = 0;
+int PeerUpdatedSendingLevel = 0;
+
+void NotifyPeerUpdated(PeerUpdate &&update) {
+	auto i = PeerUpdatedByPeerObservables.find(update.peer);
+	if (i != PeerUpdatedByPeerObservables.cend()) {
+		i->second.notify(update, true);
+	}
+	PeerUpdated().notify(std::move(update), true);
+}
+
+void ClearEmptyByPeerObservables() {
+	for (auto i = PeerUpdatedByPeerObservables.begin(); i != PeerUpdatedByPeerObservables.end();) {
+		if (i->second.empty()) {
+			i = PeerUpdatedByPeerObservables.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
 
 } // namespace
 
+void PeerUpdatedHandler::operator()(const PeerUpdate &update) const {
+	if (update.flags & _events) {
+		++PeerUpdatedHandlersCalled;
+		_handler(update);
+	}
+}
+
 void mergePeerUpdate(PeerUpdate &mergeTo, const PeerUpdate &mergeFrom) {
 	if (!(mergeTo.flags & PeerUpdate::Flag::NameChanged)) {
 		if (mergeFrom.flags & PeerUpdate::Flag::NameChanged) {
@@ -99,11 +129,19 @@ void peerUpdatedSendDelayed() {
 
 	auto smallList = base::take(*SmallUpdates);
 	auto allList = base::take(*AllUpdates);
+	auto updatesCount = smallList.size() + allList.size();
+	if (!PeerUpdatedSendingLevel++) {
+		PeerUpdatedHandlersCalled = 0;
+	}
 	for (auto &update : smallList) {
-		PeerUpdated().notify(std::move(update), true);
+		NotifyPeerUpdated(std::move(update));
 	}
 	for (auto &update : allList) {
-		PeerUpdated().notify(std::move(update), true);
+		NotifyPeerUpdated(std::move(update));
+	}
+	if (!--PeerUpdatedSendingLevel) {
+		DEBUG_LOG(("Peer updates: %1 updates sent, %2 handlers called.").arg(updatesCount).arg(PeerUpdatedHandlersCalled));
+		ClearEmptyByPeerObservables();
 	}
 
 	if (SmallUpdates->isEmpty()) {
@@ -116,4 +154,8 @@ base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated() {
 	return PeerUpdatedObservable;
 }
 
+base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated(gsl::not_null<PeerData*> peer) {
+	return PeerUpdatedByPeerObservables[peer];
+}
+
 } // namespace Notify
@@ -105,11 +105,7 @@ public:
 	template <typename Lambda>
 	PeerUpdatedHandler(PeerUpdate::Flags events, Lambda &&handler) : _events(events), _handler(std::move(handler)) {
 	}
-	void operator()(const PeerUpdate &update) const {
-		if (update.flags & _events) {
-			_handler(update);
-		}
-	}
+	void operator()(const PeerUpdate &update) const;
 
 private:
 	PeerUpdate::Flags _events;
@@ -118,4 +114,8 @@ private:
 };
 base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated();
 
+// Updates of a single peer, the handlers subscribed here are not
+// called at all for the updates of the other peers.
+base::Observable<PeerUpdate, PeerUpdatedHandler> &PeerUpdated(gsl::not_null<PeerData*> peer);
+
 } // namespace Notify
@@ -28,6 +28,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "apiwrap.h"
 #include "observer_peer.h"
 #include "auth_session.h"
+#include "data/data_online_text_changes.h"
 #include "lang.h"
 
 namespace Profile {
@@ -40,8 +41,14 @@ GroupMembersWidget::GroupMembersWidget(QWidget *parent, PeerData *peer, TitleVis
 	, (titleVisibility == TitleVisibility::Visible) ? lang(lng_profile_participants_section) : QString()
 	, st
 	, lang(lng_profile_kick)) {
-	_updateOnlineTimer.setSingleShot(true);
-	connect(&_updateOnlineTimer, SIGNAL(timeout()), this, SLOT(onUpdateOnlineDisplay()));
+	subscribe(AuthSession::Current().onlineTextChanges().changed(), [this](const std::vector<UserData*> &users) {
+		for (auto user : users) {
+			if (_membersByUser.contains(user)) {
+				updateOnlineDisplay();
+				return;
+			}
+		}
+	});
 
 	auto observeEvents = UpdateFlag::AdminsChanged
 		| UpdateFlag::MembersChanged
@@ -254,10 +261,7 @@ void GroupMembersWidget::updateItemStatusText(Item *item) {
 			member->onlineTextTill = _now + App::onlineWillChangeIn(member->onlineTill, _now);
 		}
 	}
-	if (_updateOnlineAt <= _now || _updateOnlineAt > member->onlineTextTill) {
-		_updateOnlineAt = member->onlineTextTill;
-		_updateOnlineTimer.start((_updateOnlineAt - _now + 1) * 1000);
-	}
+	AuthSession::Current().onlineTextChanges().track(user, member->onlineTextTill);
 }
 
 int GroupMembersWidget::getListTop() const {
@@ -492,7 +496,7 @@ GroupMembersWidget::Member *GroupMembersWidget::computeMember(UserData *user) {
 	return it.value();
 }
 
-void GroupMembersWidget::onUpdateOnlineDisplay() {
+void GroupMembersWidget::updateOnlineDisplay() {
 	if (_sortByOnline) {
 		_now = unixtime();
 
@@ -60,10 +60,9 @@ protected:
 signals:
 	void onlineCountUpdated(int onlineCount);
 
-private slots:
-	void onUpdateOnlineDisplay();
-
 private:
+	void updateOnlineDisplay();
+
 	// Observed notifications.
 	void notifyPeerUpdated(const Notify::PeerUpdate &update);
 
@@ -116,8 +115,6 @@ private:
 	TimeId _now = 0;
 
 	int _onlineCount = 0;
-	TimeId _updateOnlineAt = 0;
-	QTimer _updateOnlineTimer;
 
 };
 
@@ -24,6 +24,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "mainwindow.h"
 #include "messenger.h"
 #include "storage/localstorage.h"
+#include "storage/streamed_file.h"
 #include "platform/platform_file_utilities.h"
 #include "auth_session.h"
 
@@ -436,12 +437,23 @@ mtpFileLoader::mtpFileLoader(const WebFileImageLocation *location, int32 size, L
 }
 
 int32 mtpFileLoader::currentOffset(bool includeSkipped) const {
+	if (_streamed) {
+		return _streamed->loadedSize();
+	}
 	return (_fileIsOpen ? _file.size() : _data.size()) - (includeSkipped ? 0 : _skippedBytes);
 }
 
 bool mtpFileLoader::loadPart() {
 	if (_finished || _lastComplete || (!_sentRequests.empty() && !_size)) {
 		return false;
+	} else if (_streamed) {
+		auto offset = nextStreamedPartOffset();
+		if (offset < 0) {
+			return false;
+		}
+		makeRequest(offset);
+		_nextRequestOffset = offset + partSize();
+		return true;
 	} else if (_size && _nextRequestOffset >= _size) {
 		return false;
 	}
@@ -451,6 +463,87 @@ bool mtpFileLoader::loadPart() {
 	return true;
 }
 
+int mtpFileLoader::nextStreamedPartOffset() const {
+	// Continue from the last requested part, skipping the loaded and
+	// the already requested ones, wrapping to the start of the file.
+	auto from = (_nextRequestOffset < _size) ? _nextRequestOffset : 0;
+	for (auto checked = 0; checked < _size; checked += partSize()) {
+		auto offset = _streamed->firstMissingPart(from);
+		if (offset < 0) {
+			return -1;
+		}
+		auto requested = std::find_if(_sentRequests.cbegin(), _sentRequests.cend(), [offset](auto &sent) {
+			return (sent.second.offset == offset);
+		});
+		if (requested == _sentRequests.cend()) {
+			return offset;
+		}
+		from = offset + partSize();
+		if (from >= _size) {
+			from = 0;
+		}
+	}
+	return -1;
+}
+
+std::shared_ptr<Storage::StreamedFile> mtpFileLoader::startStreaming() {
+	if (_streamed) {
+		return _streamed;
+	} else if (_finished || _size <= 0 || _locationType == UnknownFileLocation) {
+		return nullptr;
+	} else if (_localStatus == LocalNotTried || _localStatus == LocalLoading) {
+		// The file may come from the local cache, not through partLoaded().
+		return nullptr;
+	}
+	_streamed = std::make_shared<Storage::StreamedFile>(_size, partSize(), _fileIsOpen ? _fname : QString());
+
+	// Parts are requested sequentially, so everything before the next
+	// request offset except the pending requests is already written
+	// to the file or to _data.
+	auto loadedTill = qMin(_nextRequestOffset, _size);
+	auto loaded = QByteArray();
+	if (_fileIsOpen) {
+		_file.flush();
+		QFile file(_fname);
+		if (file.open(QIODevice::ReadOnly)) {
+			loaded = file.read(loadedTill);
+		}
+	} else {
+		// From now on the parts are kept only in the streamed file.
+		loaded = base::take(_data);
+		loaded.truncate(loadedTill);
+	}
+	auto pending = [this](int offset) {
+		for (auto &sent : _sentRequests) {
+			if (sent.second.offset == offset) {
+				return true;
+			}
+		}
+		return false;
+	};
+	auto bytes = gsl::as_bytes(gsl::make_span(loaded));
+	for (auto offset = 0; offset < loaded.size(); offset += partSize()) {
+		auto count = qMin(partSize(), loaded.size() - offset);
+		if ((count == partSize() || offset + count == _size) && !pending(offset)) {
+			_streamed->feed(offset, bytes.subspan(offset, count));
+		}
+	}
+	_streamed->setRequestHandler([this] { streamedPartRequested(); });
+	return _streamed;
+}
+
+void mtpFileLoader::streamedPartRequested() {
+	auto offset = _streamed->takeRequestedOffset();
+	if (offset < 0 || _finished || _streamed->hasPart(offset)) {
+		return;
+	}
+
+	// Jump to the part the reader is waiting for and
+	// put this loader before all the others in the queue.
+	_nextRequestOffset = offset;
+	start(true, true);
+}
+
 int mtpFileLoader::partSize() const {
 	if (_locationType == UnknownFileLocation) {
 		return kDownloadPhotoPartSize;
@@ -590,7 +683,11 @@ void mtpFileLoader::partLoaded(int offset, base::const_byte_span bytes) {
 			if (_file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()) != qint64(bytes.size())) {
 				return cancel(true);
 			}
-		} else {
+			if (_streamed && !_file.flush()) {
+				// The streamed reader may read this part back from the disk.
+				return cancel(true);
+			}
+		} else if (!_streamed) {
 			_data.reserve(offset + bytes.size());
 			if (offset > _data.size()) {
 				_skippedBytes += offset - _data.size();
@@ -609,10 +706,19 @@ void mtpFileLoader::partLoaded(int offset, base::const_byte_span bytes) {
 			}
 		}
 	}
-	if (!bytes.size() || (bytes.size() % 1024)) { // bad next offset
+	if (_streamed) {
+		// Parts come in any order here, the last one is not an end mark.
+		_streamed->feed(offset, bytes);
+	} else if (!bytes.size() || (bytes.size() % 1024)) { // bad next offset
 		_lastComplete = true;
 	}
-	if (_sentRequests.empty() && (_lastComplete || (_size && _nextRequestOffset >= _size))) {
+	auto loadedAll = _streamed
+		? _streamed->complete()
+		: (_lastComplete || (_size && _nextRequestOffset >= _size));
+	if (_sentRequests.empty() && loadedAll) {
+		if (_streamed && !_fileIsOpen) {
+			_data = _streamed->data();
+		}
 		if (!_fname.isEmpty() && (_toCache == LoadToCacheAsWell)) {
 			if (!_fileIsOpen) _fileIsOpen = _file.open(QIODevice::WriteOnly);
 			if (!_fileIsOpen) {
@@ -758,6 +864,12 @@ bool mtpFileLoader::tryLoadLocal() {
 
 mtpFileLoader::~mtpFileLoader() {
 	cancelRequests();
+	if (_streamed) {
+		_streamed->setRequestHandler(nullptr);
+		if (!_streamed->complete()) {
+			_streamed->fail();
+		}
+	}
 }
 
 webFileLoader::webFileLoader(const QString &url, const QString &to, LoadFromCloudSetting fromCloud, bool autoLoading)
@@ -25,6 +25,8 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 
 namespace Storage {
 
+class StreamedFile;
+
 class Downloader final {
 public:
 	Downloader();
@@ -129,6 +131,11 @@ public:
 		return _autoLoading;
 	}
 
+	// Allows reading the parts of the file while it is still loading.
+	virtual std::shared_ptr<Storage::StreamedFile> startStreaming() {
+		return nullptr;
+	}
+
 	virtual void stop() {
 	}
 	virtual ~FileLoader();
@@ -199,6 +206,8 @@ public:
 		return _id;
 	}
 
+	std::shared_ptr<Storage::StreamedFile> startStreaming() override;
+
 	void stop() override {
 		rpcInvalidate();
 	}
@@ -220,6 +229,8 @@ private:
 	void makeRequest(int offset);
 
 	bool loadPart() override;
+	int nextStreamedPartOffset() const;
+	void streamedPartRequested();
 	void normalPartLoaded(const MTPupload_File &result, mtpRequestId requestId);
 	void webPartLoaded(const MTPupload_WebFile &result, mtpRequestId requestId);
 	void cdnPartLoaded(const MTPupload_CdnFile &result, mtpRequestId requestId);
@@ -254,6 +265,8 @@ private:
 	QByteArray _cdnEncryptionKey;
 	QByteArray _cdnEncryptionIV;
 
+	std::shared_ptr<Storage::StreamedFile> _streamed;
+
 };
 
 class webFileLoaderPrivate;
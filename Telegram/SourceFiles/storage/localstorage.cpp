@@ -36,6 +36,7 @@ Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
 #include "apiwrap.h"
 #include "auth_session.h"
 #include "window/window_controller.h"
+#include "chat_helpers/stickers.h"
 
 #include <openssl/evp.h>
 
@@ -43,6 +44,7 @@ namespace Local {
 namespace {
 
 constexpr int kThemeFileSizeLimit = 5 * 1024 * 1024;
+constexpr auto kWaveformCountersCount = 2;
 
 using FileKey = quint64;
 
@@ -66,6 +68,12 @@ bool _started = false;
 internal::Manager *_manager = nullptr;
 TaskQueue *_localLoader = nullptr;
 
+// Counting a waveform decodes the whole voice message, so it is done in
+// separate queues: several messages are decoded in parallel and the
+// images loading in _localLoader doesn't wait for them.
+TaskQueue *_waveformCounters[kWaveformCountersCount] = { nullptr };
+int _waveformCounterIndex = 0;
+
 bool _working() {
 	return _manager && !_basePath.isEmpty();
 }
@@ -2208,6 +2216,9 @@ void finish() {
 		_manager->deleteLater();
 		_manager = 0;
 		delete base::take(_localLoader);
+		for (auto &counter : _waveformCounters) {
+			delete base::take(counter);
+		}
 	}
 }
 
@@ -2218,6 +2229,9 @@ void start() {
 
 	_manager = new internal::Manager();
 	_localLoader = new TaskQueue(0, FileLoaderQueueStopTimeout);
+	for (auto &counter : _waveformCounters) {
+		counter = new TaskQueue(0, FileLoaderQueueStopTimeout);
+	}
 
 	_basePath = cWorkingDir() + qsl("tdata/");
 	if (!QDir().exists(_basePath)) QDir().mkpath(_basePath);
@@ -2350,6 +2364,11 @@ void reset() {
 	if (_localLoader) {
 		_localLoader->stop();
 	}
+	for (auto counter : _waveformCounters) {
+		if (counter) {
+			counter->stop();
+		}
+	}
 
 	_passKeySalt.clear(); // reset passcode, local key
 	_draftsMap.clear();
@@ -3111,10 +3130,12 @@ protected:
 
 void countVoiceWaveform(DocumentData *document) {
 	if (VoiceData *voice = document->voice()) {
-		if (_localLoader) {
+		if (auto counter = _waveformCounters[_waveformCounterIndex]) {
+			_waveformCounterIndex = (_waveformCounterIndex + 1) % kWaveformCountersCount;
+
 			voice->waveform.resize(1 + sizeof(TaskId));
 			voice->waveform[0] = -1; // counting
-			TaskId taskId = _localLoader->addTask(MakeShared<CountWaveformTask>(document));
+			TaskId taskId = counter->addTask(MakeShared<CountWaveformTask>(document));
 			memcpy(voice->waveform.data() + 1, &taskId, sizeof(taskId));
 		}
 	}
@@ -3124,6 +3145,11 @@ void cancelTask(TaskId id) {
 	if (_localLoader) {
 		_localLoader->cancelTask(id);
 	}
+	for (auto counter : _waveformCounters) {
+		if (counter) {
+			counter->cancelTask(id);
+		}
+	}
 }
 
 void _writeStickerSet(QDataStream &stream, const Stickers::Set &set) {
@@ -3377,6 +3403,9 @@ void _readStickerSets(FileKey &stickersKey, Stickers::Order *outOrder = nullptr,
 void writeInstalledStickers() {
 	if (!Global::started()) return;
 
+	// Every change of the installed sets ends up being written here.
+	Stickers::InvalidateListsByEmoji();
+
 	_writeStickerSets(_installedStickersKey, [](const Stickers::Set &set) {
 		if (set.id == Stickers::CloudRecentSetId) { // separate file for recent
 			return StickerSetCheckResult::Skip;
@@ -3519,6 +3548,7 @@ void readInstalledStickers() {
 
 	Global::RefStickerSets().clear();
 	_readStickerSets(_installedStickersKey, &Global::RefStickerSetsOrder(), qFlags(MTPDstickerSet::Flag::f_installed));
+	Stickers::InvalidateListsByEmoji();
 }
 
 void readFeaturedStickers() {
@@ -0,0 +1,239 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "storage/streamed_file.h"
+
+#include "base/task_queue.h"
+
+namespace Storage {
+namespace {
+
+constexpr auto kWaitForPartSlice = 100; // Check for interruption each 100ms.
+
+// When the file is written to disk only that many parts are kept in memory.
+constexpr auto kMaxPartsInMemory = 16;
+
+} // namespace
+
+StreamedFile::StreamedFile(int size, int partSize, const QString &path)
+: _size(size)
+, _partSize(partSize)
+, _loadedParts((size + partSize - 1) / partSize, false)
+, _file(path) {
+	Expects(_size > 0);
+	Expects(_partSize > 0);
+}
+
+void StreamedFile::setRequestHandler(base::lambda<void()> handler) {
+	_requestHandler = std::move(handler);
+}
+
+void StreamedFile::feed(int offset, base::const_byte_span bytes) {
+	Expects(!(offset % _partSize));
+
+	if (bytes.empty() || offset >= _size) {
+		return;
+	}
+	auto size = qMin(int(bytes.size()), _size - offset);
+	{
+		QMutexLocker lock(&_mutex);
+		if (hasPartLocked(offset)) {
+			return;
+		}
+		_loadedParts[offset / _partSize] = true;
+		_parts.emplace(offset, QByteArray(reinterpret_cast<const char*>(bytes.data()), size));
+		_loadedSize += size;
+		if (_requestedOffset == offset) {
+			_requestedOffset = -1;
+		}
+		trimPartsLocked();
+	}
+	_waitCondition.wakeAll();
+}
+
+void StreamedFile::fail() {
+	{
+		QMutexLocker lock(&_mutex);
+		_failed = true;
+	}
+	_waitCondition.wakeAll();
+}
+
+bool StreamedFile::hasPart(int offset) const {
+	QMutexLocker lock(&_mutex);
+	return hasPartLocked(offset);
+}
+
+bool StreamedFile::hasPartLocked(int offset) const {
+	return _loadedParts[offset / _partSize];
+}
+
+bool StreamedFile::complete() const {
+	QMutexLocker lock(&_mutex);
+	return (_loadedSize >= _size);
+}
+
+int StreamedFile::loadedSize() const {
+	QMutexLocker lock(&_mutex);
+	return _loadedSize;
+}
+
+int StreamedFile::firstMissingPart(int from) const {
+	QMutexLocker lock(&_mutex);
+	from -= (from % _partSize);
+	for (auto offset = from; offset < _size; offset += _partSize) {
+		if (!hasPartLocked(offset)) {
+			return offset;
+		}
+	}
+	for (auto offset = 0; offset < from; offset += _partSize) {
+		if (!hasPartLocked(offset)) {
+			return offset;
+		}
+	}
+	return -1;
+}
+
+int StreamedFile::takeRequestedOffset() {
+	QMutexLocker lock(&_mutex);
+	return std::exchange(_requestedOffset, -1);
+}
+
+int StreamedFile::read(int offset, char *buffer, int size, const QAtomicInt &interrupted) {
+	if (offset < 0 || offset >= _size) {
+		return 0;
+	}
+	size = qMin(size, _size - offset);
+
+	QMutexLocker lock(&_mutex);
+	while (true) {
+		if (_failed) {
+			return -1;
+		}
+		auto partOffset = offset - (offset % _partSize);
+		if (hasPartLocked(partOffset)) {
+			_readOffset = offset;
+
+			// Copy all the contiguous bytes we have starting from offset.
+			auto result = 0;
+			while (result < size && hasPartLocked(partOffset)) {
+				auto part = partLocked(partOffset);
+				if (part.isEmpty()) {
+					return result ? result : -1;
+				}
+				auto skip = offset + result - partOffset;
+				auto count = qMin(part.size() - skip, size - result);
+				memcpy(buffer + result, part.constData() + skip, count);
+				result += count;
+				partOffset += _partSize;
+			}
+			trimPartsLocked();
+			return result;
+		}
+		requestPartLocked(partOffset);
+		_waitCondition.wait(&_mutex, kWaitForPartSlice);
+		if (interrupted.loadAcquire() || QThread::currentThread()->isInterruptionRequested()) {
+			return -1;
+		}
+	}
+}
+
+QByteArray StreamedFile::data() {
+	QMutexLocker lock(&_mutex);
+	Expects(_loadedSize >= _size);
+	Expects(_file.fileName().isEmpty());
+
+	if (_data.isEmpty()) {
+		_data.reserve(_size);
+		for (auto &part : base::take(_parts)) {
+			_data.append(part.second);
+		}
+	}
+	return _data;
+}
+
+QByteArray StreamedFile::partLocked(int offset) {
+	auto size = qMin(_partSize, _size - offset);
+	if (!_data.isEmpty()) {
+		// The parts were joined, read them without copying.
+		return QByteArray::fromRawData(_data.constData() + offset, size);
+	}
+	auto i = _parts.find(offset);
+	if (i != _parts.cend()) {
+		return i->second;
+	}
+
+	// The part was loaded and dropped from memory, read it back.
+	if (!_file.isOpen() && !_file.open(QIODevice::ReadOnly)) {
+		return QByteArray();
+	} else if (!_file.seek(offset)) {
+		return QByteArray();
+	}
+	auto bytes = _file.read(size);
+	if (bytes.size() != size) {
+		return QByteArray();
+	}
+	return _parts.emplace(offset, std::move(bytes)).first->second;
+}
+
+void StreamedFile::trimPartsLocked() {
+	if (_file.fileName().isEmpty()) {
+		return;
+	}
+	while (_parts.size() > kMaxPartsInMemory) {
+		// Drop the part that is the farthest from the read position.
+		auto first = _parts.begin();
+		auto last = std::prev(_parts.end());
+		auto firstDistance = qAbs(first->first - _readOffset);
+		auto lastDistance = qAbs(last->first - _readOffset);
+		_parts.erase((firstDistance > lastDistance) ? first : last);
+	}
+}
+
+void StreamedFile::wakeReaders() {
+	_waitCondition.wakeAll();
+}
+
+void StreamedFile::requestPartLocked(int offset) {
+	if (_requestedOffset == offset) {
+		return;
+	}
+	_requestedOffset = offset;
+	if (!_requestPosted) {
+		_requestPosted = true;
+		base::TaskQueue::Main().Put([weak = std::weak_ptr<StreamedFile>(shared_from_this())] {
+			if (auto strong = weak.lock()) {
+				strong->processRequest();
+			}
+		});
+	}
+}
+
+void StreamedFile::processRequest() {
+	{
+		QMutexLocker lock(&_mutex);
+		_requestPosted = false;
+	}
+	if (_requestHandler) {
+		_requestHandler();
+	}
+}
+
+} // namespace Storage
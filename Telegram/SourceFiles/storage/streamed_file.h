@@ -0,0 +1,97 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+#include "base/lambda.h"
+
+namespace Storage {
+
+// Parts of a file that is still being downloaded, shared between
+// the loader (main thread) and a reader that plays it (any thread).
+//
+// The reader blocks in read() until the requested bytes arrive and
+// reports the offset it is waiting for, so that the loader can put
+// that part (for example the moov atom at the end of an mp4 file
+// or the position the user has seeked to) before all the others.
+//
+// If the loader writes the file to disk only a few parts around the
+// read position are kept in memory, the others are read back from
+// the file when needed. Otherwise the parts are the only copy of the
+// loaded bytes until the loader takes them joined by data().
+class StreamedFile : public std::enable_shared_from_this<StreamedFile> {
+public:
+	StreamedFile(int size, int partSize, const QString &path);
+
+	int size() const {
+		return _size;
+	}
+	int partSize() const {
+		return _partSize;
+	}
+
+	// Main thread.
+	void setRequestHandler(base::lambda<void()> handler);
+	void feed(int offset, base::const_byte_span bytes);
+	void fail();
+	bool hasPart(int offset) const;
+	bool complete() const;
+	int loadedSize() const;
+	int firstMissingPart(int from) const;
+
+	// Only when complete and not written to disk.
+	QByteArray data();
+
+	// Returns -1 if the reader is not waiting for any part.
+	int takeRequestedOffset();
+
+	// Any thread.
+	// Returns the count of bytes read or -1 if the loading has failed
+	// or the interrupted flag was set while waiting for the bytes.
+	int read(int offset, char *buffer, int size, const QAtomicInt &interrupted);
+	void wakeReaders();
+
+private:
+	bool hasPartLocked(int offset) const;
+	QByteArray partLocked(int offset);
+	void trimPartsLocked();
+	void requestPartLocked(int offset);
+	void processRequest();
+
+	const int _size;
+	const int _partSize;
+
+	mutable QMutex _mutex;
+	QWaitCondition _waitCondition;
+	std::vector<bool> _loadedParts;
+	std::map<int, QByteArray> _parts;
+	QByteArray _data;
+	QFile _file;
+	int _loadedSize = 0;
+	int _readOffset = 0;
+	int _requestedOffset = -1;
+	bool _requestPosted = false;
+	bool _failed = false;
+
+	base::lambda<void()> _requestHandler;
+
+};
+
+} // namespace Storage
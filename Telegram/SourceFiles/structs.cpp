@@ -1283,7 +1283,15 @@ void DocumentOpenClickHandler::doOpen(DocumentData *data, HistoryItem *context,
 		if (filename.isEmpty()) return;
 	}
 
+	// Start playing the video while it is still loading.
+	auto streamVideo = playVideo && data->hasRemoteLocation() && (data->size > 0);
 	data->save(filename, action, msgId);
+	if (streamVideo && data->startStreaming()) {
+		// The video is shown right away, don't open it again when it is loaded.
+		data->save(filename, ActionOnLoadNone, msgId);
+		App::wnd()->showDocument(data, context);
+		if (App::main()) App::main()->mediaMarkRead(data);
+	}
 }
 
 void DocumentOpenClickHandler::onClickImpl() const {
@@ -1606,6 +1614,10 @@ QString DocumentData::loadingFilePath() const {
 	return loading() ? _loader->fileName() : QString();
 }
 
+std::shared_ptr<Storage::StreamedFile> DocumentData::startStreaming() {
+	return loading() ? _loader->startStreaming() : nullptr;
+}
+
 bool DocumentData::displayLoading() const {
 	return loading() ? (!_loader->loadingLocal() || !_loader->autoLoading()) : uploading();
 }
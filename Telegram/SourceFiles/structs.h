@@ -1141,6 +1141,10 @@ namespace Serialize {
 class Document;
 } // namespace Serialize;
 
+namespace Storage {
+class StreamedFile;
+} // namespace Storage
+
 class DocumentData {
 public:
 	static DocumentData *create(DocumentId id);
@@ -1168,6 +1172,9 @@ public:
 	int32 loadOffset() const;
 	bool uploading() const;
 
+	// Non-null only while the document is loading from the cloud.
+	std::shared_ptr<Storage::StreamedFile> startStreaming();
+
 	QByteArray data() const;
 	const FileLocation &location(bool check = false) const;
 	void setLocation(const FileLocation &loc);
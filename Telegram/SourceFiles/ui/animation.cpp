@@ -39,8 +39,20 @@ ReaderPointer::~ReaderPointer() {
 
 namespace {
 
+constexpr auto kHiddenFrameDelta = 200;
+constexpr auto kMaxFrameDelta = 16;
+
 AnimationManager *_manager = nullptr;
 
+bool AnyWindowExposed() {
+	for (auto window : QGuiApplication::topLevelWindows()) {
+		if (window->isExposed()) {
+			return true;
+		}
+	}
+	return false;
+}
+
 } // namespace
 
 namespace anim {
@@ -129,6 +141,31 @@ void BasicAnimation::stop() {
 AnimationManager::AnimationManager() : _timer(this), _iterating(false) {
 	_timer.setSingleShot(false);
 	connect(&_timer, SIGNAL(timeout()), this, SLOT(timeout()));
+
+	// There is no point in stepping animations more often than the screen is refreshed.
+	if (auto screen = QGuiApplication::primaryScreen()) {
+		auto refreshRate = screen->refreshRate();
+		if (refreshRate > 0.) {
+			_frameDelta = snap(int(1000. / refreshRate), int(AnimationTimerDelta), kMaxFrameDelta);
+		}
+	}
+}
+
+int AnimationManager::countFrameDelta() const {
+	return AnyWindowExposed() ? _frameDelta : kHiddenFrameDelta;
+}
+
+void AnimationManager::startTicking() {
+	_framesCount = _slowFramesCount = 0;
+	_slowestFrame = 0;
+	_timer.start(countFrameDelta());
+}
+
+void AnimationManager::stopTicking() {
+	_timer.stop();
+	if (_slowFramesCount > 0) {
+		DEBUG_LOG(("Animations: %1 of %2 frames took more than %3ms, the slowest took %4ms.").arg(_slowFramesCount).arg(_framesCount).arg(_frameDelta).arg(_slowestFrame));
+	}
 }
 
 void AnimationManager::start(BasicAnimation *obj) {
@@ -139,7 +176,7 @@ void AnimationManager::start(BasicAnimation *obj) {
 		}
 	} else {
 		if (_objects.isEmpty()) {
-			_timer.start(AnimationTimerDelta);
+			startTicking();
 		}
 		_objects.insert(obj);
 	}
@@ -156,7 +193,7 @@ void AnimationManager::stop(BasicAnimation *obj) {
 		if (i != _objects.cend()) {
 			_objects.erase(i);
 			if (_objects.empty()) {
-				_timer.stop();
+				stopTicking();
 			}
 		}
 	}
@@ -185,7 +222,22 @@ void AnimationManager::timeout() {
 		_stopping.clear();
 	}
 	if (_objects.empty()) {
-		_timer.stop();
+		stopTicking();
+		return;
+	}
+
+	auto took = getms() - ms;
+	++_framesCount;
+	if (took > _frameDelta) {
+		++_slowFramesCount;
+		accumulate_max(_slowestFrame, took);
+	}
+
+	// Slow down while all the windows are hidden or minimized,
+	// the animations still finish in time, just in fewer steps.
+	auto frameDelta = countFrameDelta();
+	if (_timer.interval() != frameDelta) {
+		_timer.start(frameDelta);
 	}
 }
 
@@ -667,9 +667,19 @@ public slots:
 	void clipCallback(Media::Clip::Reader *reader, qint32 threadIndex, qint32 notification);
 
 private:
+	void startTicking();
+	void stopTicking();
+	int countFrameDelta() const;
+
 	using AnimatingObjects = OrderedSet<BasicAnimation*>;
 	AnimatingObjects _objects, _starting, _stopping;
 	QTimer _timer;
 	bool _iterating;
 
+	// Display refresh interval, the timer is slowed down while no window is exposed.
+	int _frameDelta = AnimationTimerDelta;
+	int _framesCount = 0;
+	int _slowFramesCount = 0;
+	TimeMs _slowestFrame = 0;
+
 };
@@ -0,0 +1,88 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#include "ui/paint_timings.h"
+
+namespace Ui {
+namespace {
+
+constexpr auto kFramesPerReport = 300;
+
+} // namespace
+
+PaintTimings::PaintTimings(const QString &name) : _name(name) {
+}
+
+PaintTimings::Frame::Frame(PaintTimings *timings, int width)
+: _timings(timings)
+, _width(width) {
+	if (_timings) {
+		_timer.start();
+	}
+}
+
+PaintTimings::Frame::Frame(Frame &&other)
+: _timings(base::take(other._timings))
+, _width(other._width)
+, _timer(other._timer) {
+}
+
+PaintTimings::Frame::~Frame() {
+	if (_timings) {
+		_timings->add(_width, _timer.nsecsElapsed() / 1000);
+	}
+}
+
+PaintTimings::Frame PaintTimings::measure(int width) {
+	return Frame(cDebug() ? this : nullptr, width);
+}
+
+void PaintTimings::add(int width, int64 microseconds) {
+	if (_width != width) {
+		flush();
+		_width = width;
+	}
+	_durations.push_back(microseconds);
+	if (_durations.size() >= kFramesPerReport) {
+		flush();
+	}
+}
+
+void PaintTimings::flush() {
+	if (_durations.empty()) {
+		return;
+	}
+	auto durations = base::take(_durations);
+	auto percentile = [&durations](int percent) {
+		auto nth = durations.begin() + (durations.size() - 1) * percent / 100;
+		std::nth_element(durations.begin(), nth, durations.end());
+		return *nth;
+	};
+	DEBUG_LOG(("Paint Info: %1 at width %2, %3 frames, p50 %4us, p90 %5us, p99 %6us, max %7us"
+		).arg(_name
+		).arg(_width
+		).arg(int(durations.size())
+		).arg(percentile(50)
+		).arg(percentile(90)
+		).arg(percentile(99)
+		).arg(percentile(100)));
+}
+
+} // namespace Ui
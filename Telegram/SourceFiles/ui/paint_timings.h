@@ -0,0 +1,56 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop version of Telegram messaging app, see https://telegram.org
+
+Telegram Desktop is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+It is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+In addition, as a special exception, the copyright holders give permission
+to link the code of portions of this program with the OpenSSL library.
+
+Full license: https://github.com/telegramdesktop/tdesktop/blob/master/LICENSE
+Copyright (c) 2014-2017 John Preston, https://desktop.telegram.org
+*/
+#pragma once
+
+namespace Ui {
+
+// Measures paint calls of one widget while debug logging is enabled and
+// writes frame time percentiles to the debug log for each widget width.
+class PaintTimings {
+public:
+	explicit PaintTimings(const QString &name);
+
+	class Frame {
+	public:
+		Frame(PaintTimings *timings, int width);
+		Frame(Frame &&other);
+		Frame &operator=(Frame &&other) = delete;
+		~Frame();
+
+	private:
+		PaintTimings *_timings = nullptr;
+		int _width = 0;
+		QElapsedTimer _timer;
+
+	};
+	Frame measure(int width);
+
+private:
+	void add(int width, int64 microseconds);
+	void flush();
+
+	QString _name;
+	int _width = 0;
+	std::vector<int64> _durations;
+
+};
+
+} // namespace Ui